@@ -55,6 +55,13 @@ cdef class Plumed:
          self.c_plumed.cmd( ckey, <void*>&val )
      cdef cmd_int(self, ckey, int val):
          self.c_plumed.cmd( ckey, <void*>&val)
+     def getCommandKey( self, key ):
+         """Return a key for command key that plumed can use without parsing (requires API version 7)"""
+         cdef bytes py_bytes = ("getCommandHandle " + key).encode()
+         cdef char* ckey = py_bytes
+         cdef int handle = 0
+         self.c_plumed.cmd( ckey, <void*>&handle )
+         return "#{}".format(handle)
      def cmd( self, key, val=None ):
          cdef bytes py_bytes = key.encode()
          cdef char* ckey = py_bytes
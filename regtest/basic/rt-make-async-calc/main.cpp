@@ -0,0 +1,83 @@
+#include "plumed/wrapper/Plumed.h"
+#include <vector>
+#include <cstdio>
+#include <string>
+#include <fstream>
+
+using namespace PLMD;
+
+// Run a few steps and return the total forces.
+// mode=0: synchronous calc
+// mode=1: performCalcAsync + waitForces, with MD forces computed in the meanwhile on a separate array
+// mode=2: performCalcAsync, waiting implicitly at the next command
+std::vector<double> run(int mode,const char* log,std::vector<double> & biases) {
+  Plumed p;
+  int natoms=500;
+  unsigned nt=3;
+  p.cmd("setNumOMPthreads",&nt);
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setLogFile",log);
+  p.cmd("init");
+  p.cmd("readInputLine","c1: COM ATOMS=1-250");
+  p.cmd("readInputLine","c2: COM ATOMS=251-500");
+  p.cmd("readInputLine","d: DISTANCE ATOMS=c1,c2");
+  p.cmd("readInputLine","g: GYRATION ATOMS=1-500:3");
+  p.cmd("readInputLine","RESTRAINT ARG=d,g AT=0,0 KAPPA=1,1");
+// DEBUG calls cmd() from within the calculation, which should not wait for the calculation itself
+  std::string debug="DEBUG logRequestedAtoms STRIDE=2 FILE=debug"+std::to_string(mode);
+  p.cmd("readInputLine",debug.c_str());
+
+  std::vector<double> positions(3*natoms), forces(3*natoms), mdforces(3*natoms), masses(natoms,1.0);
+  std::vector<double> box(9,0.0), virial(9,0.0);
+  for(int step=0; step<5; step++) {
+    for(int i=0; i<natoms; i++) for(int k=0; k<3; k++) positions[3*i+k]=0.001*((i*(k+7)+step*13)%1000)+0.0002*i;
+    for(auto & f : forces) f=0.0;
+    p.cmd("setStep",&step);
+    p.cmd("setPositions",&positions[0]);
+    p.cmd("setForces",&forces[0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("setBox",&box[0]);
+    p.cmd("setVirial",&virial[0]);
+    if(mode==0) p.cmd("calc");
+    else {
+      p.cmd("prepareCalc");
+      p.cmd("performCalcAsync");
+    }
+// mimic the force calculation of the MD code, on its own array
+    for(int i=0; i<3*natoms; i++) mdforces[i]=-0.01*positions[i];
+    if(mode==1) p.cmd("waitForces");
+    double bias;
+    p.cmd("getBias",&bias);
+    biases.push_back(bias);
+    for(int i=0; i<3*natoms; i++) forces[i]+=mdforces[i];
+  }
+  return forces;
+}
+
+int main() {
+  std::vector<double> b0,b1,b2;
+  std::vector<double> f0=run(0,"sync.log",b0);
+  std::vector<double> f1=run(1,"async.log",b1);
+  std::vector<double> f2=run(2,"async_implicit.log",b2);
+
+  FILE* fp=std::fopen("output","w");
+  for(unsigned i=0; i<b0.size(); i++) std::fprintf(fp,"bias %u %10.4f %10.4f %10.4f\n",i,b0[i],b1[i],b2[i]);
+  for(unsigned i=0; i<f0.size()/3; i+=23) {
+    std::fprintf(fp,"%5d",i);
+    for(int k=0; k<3; k++) std::fprintf(fp," %8.3f %8.3f %8.3f",1000*f0[3*i+k],1000*f1[3*i+k],1000*f2[3*i+k]);
+    std::fprintf(fp,"\n");
+  }
+// the atoms logged by DEBUG in each mode
+  for(int mode=0; mode<3; mode++) {
+    std::ifstream ifs("debug"+std::to_string(mode));
+    std::string line;
+    while(std::getline(ifs,line)) {
+      std::size_t colon=line.find(':');
+      int natoms=0;
+      for(std::size_t i=colon+1; i<line.size(); i++) if(line[i]==' ' && i+1<line.size() && line[i+1]!=' ') natoms++;
+      std::fprintf(fp,"debug %d %s %d\n",mode,line.substr(0,colon).c_str(),natoms);
+    }
+  }
+  std::fclose(fp);
+  return 0;
+}
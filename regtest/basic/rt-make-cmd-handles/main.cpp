@@ -0,0 +1,87 @@
+#include "plumed/wrapper/Plumed.h"
+#include <vector>
+#include <fstream>
+#include <string>
+
+using namespace PLMD;
+
+// resolve a command once and return its handle
+int handle(Plumed & p,const std::string & name) {
+  int h=-1;
+  p.cmd(("getCommandHandle "+name).c_str(),&h);
+  return h;
+}
+
+int main() {
+  Plumed p;
+
+  int natoms=10;
+
+  std::vector<double> positions(3*natoms,0.0);
+  for(unsigned i=0; i<3*natoms; i++) positions[i]=0.1*i;
+  std::vector<double> masses(natoms,1.0);
+  std::vector<double> forces(3*natoms,0.0);
+  std::vector<double> box(9,0.0);
+  std::vector<double> virial(9,0.0);
+
+  std::ofstream ofs("output");
+
+  int api=0;
+  p.cmd("getApiVersion",&api);
+  ofs<<"api>=7: "<<(api>=7)<<"\n";
+
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setLogFile","test.log");
+  p.cmd("init");
+  p.cmd("readInputLine","d: DISTANCE ATOMS=1,2");
+  p.cmd("readInputLine","RESTRAINT ARG=d AT=0 KAPPA=1");
+  p.cmd("readInputLine","PRINT ARG=d FILE=COLVAR");
+
+  const int setStep=handle(p,"setStep");
+  const int setPositions=handle(p,"setPositions");
+  const int setBox=handle(p,"setBox");
+  const int setForces=handle(p,"setForces");
+  const int setVirial=handle(p,"setVirial");
+  const int setMasses=handle(p,"setMasses");
+  const int calc=handle(p,"calc");
+// the key "#<handle>" can also be passed as a string
+  const std::string getBias="#"+std::to_string(handle(p,"getBias"));
+
+  for(int step=0; step<5; step++) {
+    positions[0]=0.1*step;
+    for(auto & f : forces) f=0.0;
+    p.cmd(setStep,&step);
+    p.cmd(setPositions,&positions[0]);
+    p.cmd(setBox,&box[0]);
+    p.cmd(setForces,&forces[0]);
+    p.cmd(setVirial,&virial[0]);
+    p.cmd(setMasses,&masses[0]);
+    p.cmd(calc);
+    double bias;
+    p.cmd(getBias.c_str(),&bias);
+    ofs<<"bias: "<<bias<<" f0: "<<forces[0]<<"\n";
+  }
+
+  // commands with additional words cannot be resolved in advance
+  try {
+    int handle;
+    p.cmd("getCommandHandle setExtraCV",&handle);
+    ofs<<"no exception for setExtraCV\n";
+  } catch(Plumed::Exception & e) {
+    ofs<<"exception for setExtraCV\n";
+  }
+  // and invalid handles are detected
+  try {
+    p.cmd("#100000");
+    ofs<<"no exception for invalid handle\n";
+  } catch(Plumed::Exception & e) {
+    ofs<<"exception for invalid handle\n";
+  }
+  try {
+    p.cmd(-1);
+    ofs<<"no exception for negative handle\n";
+  } catch(Plumed::Exception & e) {
+    ofs<<"exception for negative handle\n";
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include "plumed/wrapper/Plumed.h"
+#include <vector>
+#include <fstream>
+#include <cstdio>
+
+using namespace PLMD;
+
+// Run a few steps passing atoms in the order given by gatindex and return the forces in the global order
+template<typename real>
+std::vector<real> run(const std::vector<int> & gatindex,int natoms,const char* log) {
+  Plumed p;
+  int precision=sizeof(real);
+  unsigned nt=3;
+  p.cmd("setRealPrecision",&precision);
+  p.cmd("setNumOMPthreads",&nt);
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setLogFile",log);
+  p.cmd("init");
+  p.cmd("readInputLine","c1: COM ATOMS=1-1000");
+  p.cmd("readInputLine","c2: COM ATOMS=1001-2000");
+  p.cmd("readInputLine","d: DISTANCE ATOMS=c1,c2");
+  p.cmd("readInputLine","g: GYRATION ATOMS=1-2000:3");
+  p.cmd("readInputLine","RESTRAINT ARG=d,g AT=0,0 KAPPA=1,1");
+
+  int nlocal=gatindex.size();
+  std::vector<real> positions(3*nlocal), forces(3*nlocal), masses(nlocal,1.0);
+  std::vector<real> box(9,0.0), virial(9,0.0);
+  std::vector<real> global(3*natoms,0.0);
+  p.cmd("setAtomsNlocal",&nlocal);
+  p.cmd("setAtomsGatindex",const_cast<int*>(&gatindex[0]));
+  for(int step=0; step<3; step++) {
+    for(int i=0; i<nlocal; i++) for(int k=0; k<3; k++) positions[3*i+k]=0.001*((gatindex[i]*(k+7)+step*13)%1000)+0.0002*gatindex[i];
+    for(auto & f : forces) f=0.0;
+    p.cmd("setStep",&step);
+    p.cmd("setPositions",&positions[0]);
+    p.cmd("setForces",&forces[0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("setBox",&box[0]);
+    p.cmd("setVirial",&virial[0]);
+    p.cmd("calc");
+  }
+  for(int i=0; i<nlocal; i++) for(int k=0; k<3; k++) global[3*gatindex[i]+k]=forces[3*i+k];
+  return global;
+}
+
+int main() {
+  int natoms=2000;
+  std::vector<int> ordered(natoms), shuffled(natoms);
+  for(int i=0; i<natoms; i++) ordered[i]=i;
+  for(int i=0; i<natoms; i++) shuffled[i]=(i*7)%natoms;
+
+  std::vector<double> fd=run<double>(ordered,natoms,"ordered.log");
+  std::vector<double> fds=run<double>(shuffled,natoms,"shuffled.log");
+  std::vector<float> ff=run<float>(ordered,natoms,"ordered_float.log");
+  std::vector<float> ffs=run<float>(shuffled,natoms,"shuffled_float.log");
+
+  FILE* fp=std::fopen("output","w");
+  for(int i=0; i<natoms; i+=97) {
+    std::fprintf(fp,"%5d",i);
+    for(int k=0; k<3; k++) std::fprintf(fp," %8.3f %8.3f %8.3f %8.3f",1000*fd[3*i+k],1000*fds[3*i+k],1000*ff[3*i+k],1000*ffs[3*i+k]);
+    std::fprintf(fp,"\n");
+  }
+  std::fclose(fp);
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "plumed/lepton/Lepton.h"
+#include "plumed/tools/SwitchingFunction.h"
+#include "plumed/tools/Exception.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdio>
+#include <cmath>
+
+using namespace PLMD;
+
+// Batches of n points are evaluated in blocks, so n is chosen not to be a multiple of the block size
+const unsigned n=150;
+
+void testExpression(FILE* fp,const std::string & expr) {
+  lepton::CompiledExpression ce=lepton::Parser::parse(expr).optimize(lepton::Constants()).createCompiledExpression();
+  std::vector<double> x(n), y(n), batch(n);
+  for(unsigned i=0; i<n; i++) {
+    x[i]=-2.0+0.03*i;
+    y[i]=0.5+0.01*((7*i)%n);
+  }
+// z is not passed in the batch and keeps the value set here
+  if(ce.getVariables().count("z")) ce.getVariableReference("z")=0.7;
+  std::map<std::string,const double*> inputs;
+  if(ce.getVariables().count("x")) inputs["x"]=&x[0];
+  if(ce.getVariables().count("y")) inputs["y"]=&y[0];
+  ce.evaluate(inputs,&batch[0],n);
+  double maxdiff=0.0;
+  for(unsigned i=0; i<n; i++) {
+    if(ce.getVariables().count("x")) ce.getVariableReference("x")=x[i];
+    if(ce.getVariables().count("y")) ce.getVariableReference("y")=y[i];
+    maxdiff=std::max(maxdiff,std::fabs(ce.evaluate()-batch[i]));
+  }
+  std::fprintf(fp,"%s\n  max difference %g\n ",expr.c_str(),maxdiff);
+  for(unsigned i=0; i<n; i+=37) std::fprintf(fp," %12.6f",batch[i]);
+  std::fprintf(fp,"\n");
+}
+
+void testSwitch(FILE* fp,const std::string & def) {
+  SwitchingFunction sf;
+  std::string errors;
+  sf.set(def,errors);
+  plumed_massert(errors.length()==0,errors);
+  std::vector<double> d2(n), batch(n), dbatch(n);
+  for(unsigned i=0; i<n; i++) d2[i]=0.0001+0.002*i;
+  sf.calculateSqr(n,&d2[0],&batch[0],&dbatch[0]);
+  double maxdiff=0.0, maxddiff=0.0;
+  for(unsigned i=0; i<n; i++) {
+    double df;
+    const double f=sf.calculateSqr(d2[i],df);
+    maxdiff=std::max(maxdiff,std::fabs(f-batch[i]));
+    maxddiff=std::max(maxddiff,std::fabs(df-dbatch[i]));
+  }
+  std::fprintf(fp,"%s\n  max difference %g %g\n ",def.c_str(),maxdiff,maxddiff);
+  for(unsigned i=0; i<n; i+=37) std::fprintf(fp," %12.6f %12.6f",batch[i],dbatch[i]);
+  std::fprintf(fp,"\n");
+}
+
+int main() {
+  FILE* fp=std::fopen("output","w");
+  testExpression(fp,"x^2+3*x*y-y^3");
+  testExpression(fp,"sin(x)*exp(-y^2)+cos(x*y)/(1+y)");
+  testExpression(fp,"sqrt(y)*log(y)+x^4-x^-2+z");
+  testExpression(fp,"step(x)*erf(y)+select(x,y,z)+min(x,y)+abs(x)");
+  testSwitch(fp,"RATIONAL R_0=0.2 NN=6 MM=12");
+  testSwitch(fp,"CUSTOM FUNC=1/(1+x^6) R_0=0.2");
+  testSwitch(fp,"CUSTOM FUNC=exp(-x^2)*(1-x) R_0=0.3 D_MAX=0.4");
+  std::fclose(fp);
+  return 0;
+}
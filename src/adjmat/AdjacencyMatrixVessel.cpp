@@ -22,6 +22,7 @@
 #include "AdjacencyMatrixVessel.h"
 #include "AdjacencyMatrixBase.h"
 #include "vesselbase/ActionWithVessel.h"
+#include "tools/OpenMP.h"
 
 namespace PLMD {
 namespace adjmat {
@@ -99,25 +100,43 @@ void AdjacencyMatrixVessel::retrieveMatrix( DynamicList<unsigned>& myactive_elem
   myactive_elements.updateActiveMembers();
 }
 
-void AdjacencyMatrixVessel::retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list ) {
+void AdjacencyMatrixVessel::retrieveAdjacencyLists( std::vector<unsigned>& offsets, std::vector<unsigned>& adj_list ) {
   plumed_dbg_assert( undirectedGraph() );
-  // Currently everything has zero neighbors
-  for(unsigned i=0; i<nneigh.size(); ++i) nneigh[i]=0;
-
-  // And set up the adjacency list
-  std::vector<double> myvals( getNumberOfComponents() );
-  for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
-    // Check if atoms are connected
-    retrieveSequentialValue( i, false, myvals );
-    if( myvals[0]<epsilon || myvals[1]<epsilon ) continue ;
-
-    unsigned j, k; getMatrixIndices( function->getPositionInFullTaskList(i), k, j );
+  const unsigned nnodes=getNumberOfRows(), nt=OpenMP::getNumThreads();
+
+  // Find the pairs of atoms that are connected.  Each thread stores the edges it finds in its own list
+  std::vector<std::vector<std::pair<unsigned,unsigned> > > edges( nt );
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<std::pair<unsigned,unsigned> >& myedges( edges[OpenMP::getThreadNum()] );
+    std::vector<double> myvals( getNumberOfComponents() );
+    #pragma omp for schedule(static) nowait
+    for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
+      // Check if atoms are connected
+      retrieveSequentialValue( i, false, myvals );
+      if( myvals[0]<epsilon || myvals[1]<epsilon ) continue ;
+
+      unsigned j, k; getMatrixIndices( function->getPositionInFullTaskList(i), k, j );
+      myedges.push_back( std::pair<unsigned,unsigned>( k, j ) );
+    }
+  }
 
-    if( nneigh[j]>=adj_list.ncols() || nneigh[k]>=adj_list.ncols() ) error("adjacency lists are not large enough, increase maxconnections");
-    // Store if atoms are connected
-    // unsigned j, k; getMatrixIndices( i, k, j );
-    adj_list(k,nneigh[k])=j; nneigh[k]++;
-    adj_list(j,nneigh[j])=k; nneigh[j]++;
+  // Count the number of neighbors of each node
+  offsets.assign( nnodes+1, 0 );
+  for(unsigned t=0; t<nt; ++t) {
+    for(unsigned i=0; i<edges[t].size(); ++i) { offsets[edges[t][i].first+1]++; offsets[edges[t][i].second+1]++; }
+  }
+  for(unsigned i=0; i<nnodes; ++i) offsets[i+1]+=offsets[i];
+
+  // And set up the adjacency lists.  The threads are visited in order so that the
+  // neighbors of each node appear in the order in which they are stored
+  adj_list.resize( offsets[nnodes] ); std::vector<unsigned> nneigh( offsets.begin(), offsets.end()-1 );
+  for(unsigned t=0; t<nt; ++t) {
+    for(unsigned i=0; i<edges[t].size(); ++i) {
+      unsigned k=edges[t][i].first, j=edges[t][i].second;
+      adj_list[nneigh[k]]=j; nneigh[k]++;
+      adj_list[nneigh[j]]=k; nneigh[j]++;
+    }
   }
 }
 
@@ -56,8 +56,9 @@ public:
   unsigned getStoreIndexFromMatrixIndices( const unsigned& ielem, const unsigned& jelem ) const ;
 /// Get the adjacency matrix
   void retrieveMatrix( DynamicList<unsigned>& myactive_elements, Matrix<double>& mymatrix );
-/// Get the neighbour list based on the adjacency matrix
-  void retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list );
+/// Get the neighbour lists based on the adjacency matrix in compressed sparse row format.
+/// The neighbours of node i are in adj_list[offsets[i]] ... adj_list[offsets[i+1]-1]
+  void retrieveAdjacencyLists( std::vector<unsigned>& offsets, std::vector<unsigned>& adj_list );
 /// Retrieve the list of edges in the adjacency matrix/graph
   void retrieveEdgeList( unsigned& nedge, std::vector<std::pair<unsigned,unsigned> >& edge_list );
 ///
@@ -22,6 +22,9 @@
 #include "ClusteringBase.h"
 #include "AdjacencyMatrixVessel.h"
 #include "core/ActionRegister.h"
+#include "tools/OpenMP.h"
+#include <atomic>
+#include <memory>
 
 #ifdef __PLUMED_HAS_BOOST_GRAPH
 #include <boost/graph/adjacency_list.hpp>
@@ -44,6 +47,10 @@ https://en.wikipedia.org/wiki/Depth-first_search
 This action is useful if you are looking at a phenomenon such as nucleation where the aim is to detect the sizes of the crystalline nuclei that have formed
 in your simulation cell.
 
+Unless PLUMED is compiled with the boost graph library the connected components are found with a union-find algorithm
+that runs on multiple OpenMP threads and that does not store the full list of neighbors of each node in a dense array.
+The clusters found are the same that would be found by a depth first search.
+
 \par Examples
 
 The input below calculates the coordination numbers of atoms 1-100 and then computes the an adjacency
@@ -73,14 +80,16 @@ private:
 /// The list of edges in the graph
   std::vector<std::pair<unsigned,unsigned> > edge_list;
 #else
-/// The number of neighbors each atom has
-  std::vector<unsigned> nneigh;
-/// The adjacency list
-  Matrix<unsigned> adj_list;
-/// The color that tells us whether a node has been visited
-  std::vector<unsigned> color;
-/// The recursive function at the heart of this method
-  int explore( const unsigned& index );
+/// The position of the first neighbor of each node in adj_list
+  std::vector<unsigned> offsets;
+/// The adjacency lists in compressed sparse row format
+  std::vector<unsigned> adj_list;
+/// The parent of each node in the union-find forest
+  std::unique_ptr<std::atomic<unsigned>[]> parent;
+/// Find the root of the tree containing node index
+  unsigned findRoot( unsigned index );
+/// Merge the trees containing nodes i and j
+  void merge( unsigned i, unsigned j );
 #endif
 public:
 /// Create manual
@@ -98,7 +107,7 @@ void DFSClustering::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","MAXCONNECT","0","maximum number of connections that can be formed by any given node in the graph. "
            "By default this is set equal to zero and the number of connections is set equal to the number "
            "of nodes.  You only really need to set this if you are working with a very large system and "
-           "memory is at a premium");
+           "memory is at a premium.  This is only used when PLUMED is compiled with the boost graph library");
 }
 
 DFSClustering::DFSClustering(const ActionOptions&ao):
@@ -110,9 +119,7 @@ DFSClustering::DFSClustering(const ActionOptions&ao):
   if( maxconnections>0 ) edge_list.resize( getNumberOfNodes()*maxconnections );
   else edge_list.resize(0.5*getNumberOfNodes()*(getNumberOfNodes()-1));
 #else
-  nneigh.resize( getNumberOfNodes() ); color.resize(getNumberOfNodes());
-  if( maxconnections>0 ) adj_list.resize(getNumberOfNodes(),maxconnections);
-  else adj_list.resize(getNumberOfNodes(),getNumberOfNodes());
+  parent.reset( new std::atomic<unsigned>[getNumberOfNodes()] );
 #endif
 }
 
@@ -130,30 +137,57 @@ void DFSClustering::performClustering() {
   // And work out the size of each cluster
   for(unsigned i=0; i<which_cluster.size(); ++i) cluster_sizes[which_cluster[i]].first++;
 #else
-  // Get the adjacency matrix
-  getAdjacencyVessel()->retrieveAdjacencyLists( nneigh, adj_list );
+  // Get the adjacency lists
+  getAdjacencyVessel()->retrieveAdjacencyLists( offsets, adj_list );
+
+  // Every node is initially in a cluster of its own
+  const unsigned nnodes=getNumberOfNodes(), nt=OpenMP::getNumThreads();
+  #pragma omp parallel num_threads(nt)
+  {
+    #pragma omp for
+    for(unsigned i=0; i<nnodes; ++i) parent[i].store( i, std::memory_order_relaxed );
+    // Merge the trees of the nodes that are connected
+    #pragma omp for schedule(dynamic,64)
+    for(unsigned i=0; i<nnodes; ++i) {
+      for(unsigned k=offsets[i]; k<offsets[i+1]; ++k) {
+        if( adj_list[k]>i ) merge( i, adj_list[k] );
+      }
+    }
+  }
 
-  // Perform clustering
-  number_of_cluster=-1; color.assign(color.size(),0);
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( color[i]==0 ) { number_of_cluster++; color[i]=explore(i); }
+  // The root of each tree is its node with the lowest index so numbering the clusters in order of their
+  // roots gives the same numbering as a depth first search started from each node in turn
+  number_of_cluster=-1;
+  for(unsigned i=0; i<nnodes; ++i) {
+    unsigned root=findRoot(i);
+    if( root==i ) { number_of_cluster++; which_cluster[i]=number_of_cluster; }
+    else which_cluster[i]=which_cluster[root];
+    cluster_sizes[which_cluster[i]].first++;
   }
 #endif
 }
 
 #ifndef __PLUMED_HAS_BOOST_GRAPH
-int DFSClustering::explore( const unsigned& index ) {
-
-  color[index]=1;
-  for(unsigned i=0; i<nneigh[index]; ++i) {
-    unsigned j=adj_list(index,i);
-    if( color[j]==0 ) color[j]=explore(j);
+unsigned DFSClustering::findRoot( unsigned index ) {
+  while( true ) {
+    unsigned p=parent[index].load( std::memory_order_relaxed );
+    if( p==index ) return index;
+    // Path halving: the tree gets flatter each time it is traversed
+    unsigned gp=parent[p].load( std::memory_order_relaxed );
+    if( gp!=p ) parent[index].compare_exchange_weak( p, gp, std::memory_order_relaxed );
+    index=gp;
   }
+}
 
-  // Count the size of the cluster
-  cluster_sizes[number_of_cluster].first++;
-  which_cluster[index] = number_of_cluster;
-  return color[index];
+void DFSClustering::merge( unsigned i, unsigned j ) {
+  while( true ) {
+    i=findRoot(i); j=findRoot(j);
+    if( i==j ) return;
+    // The root with the larger index is attached to the other one so the root of each tree is its lowest index
+    if( i<j ) std::swap(i,j);
+    unsigned expected=i;
+    if( parent[i].compare_exchange_strong( expected, j ) ) return;
+  }
 }
 #endif
 
@@ -24,11 +24,17 @@
 #include "core/ActionRegister.h"
 #include "reference/MetricRegister.h"
 #include "reference/ReferenceConfiguration.h"
+#include "tools/OpenMP.h"
+#include <memory>
 
 //+PLUMEDOC ANALYSIS EUCLIDEAN_DISSIMILARITIES
 /*
 Calculate the matrix of dissimilarities between a trajectory of atomic configurations.
 
+The reference configurations are constructed once for each frame. Unless LOWMEM is used,
+the full matrix is then computed in blocks of frames that are shared among the
+OpenMP threads and the MPI processes.
+
 \par Examples
 
 */
@@ -42,6 +48,10 @@ private:
   PDB mypdb;
   std::string mtype;
   Matrix<double> dissimilarities;
+/// The reference configurations for all the frames
+  std::vector<std::unique_ptr<ReferenceConfiguration> > myrefs;
+/// Compute the dissimilarity between two frames
+  double calculateDissimilarity( const unsigned& i, const unsigned& j );
 public:
   static void registerKeywords( Keywords& keys );
   EuclideanDissimilarityMatrix( const ActionOptions& ao );
@@ -114,31 +124,50 @@ EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions&
 }
 
 void EuclideanDissimilarityMatrix::performAnalysis() {
+  const unsigned ndata=getNumberOfDataPoints();
+  // Build the reference configurations once for each frame
+  myrefs.resize( ndata );
+  for(unsigned i=0; i<ndata; ++i) {
+    getStoredData( i, true ).transferDataToPDB( mypdb );
+    myrefs[i]=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
+  }
+  if( usingLowMem() ) return;
   // Resize dissimilarities matrix and set all elements to zero
-  if( !usingLowMem() ) {
-    dissimilarities.resize( getNumberOfDataPoints(), getNumberOfDataPoints() ); dissimilarities=0;
+  dissimilarities.resize( ndata, ndata ); dissimilarities=0;
+  // The upper triangle is divided in blocks of frames so that the reference configurations
+  // of each block are reused while in cache. Blocks are shared among processes and threads.
+  const unsigned bsize=32, nblocks=(ndata+bsize-1)/bsize;
+  std::vector<std::pair<unsigned,unsigned> > blocks;
+  for(unsigned ib=0; ib<nblocks; ++ib) {
+    for(unsigned jb=ib; jb<nblocks; ++jb) blocks.push_back( std::pair<unsigned,unsigned>(ib,jb) );
+  }
+  const unsigned stride=comm.Get_size(), rank=comm.Get_rank();
+  const unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel for num_threads(nt) schedule(dynamic)
+  for(unsigned k=rank; k<blocks.size(); k+=stride) {
+    const unsigned iend=std::min( ndata, (blocks[k].first+1)*bsize );
+    const unsigned jend=std::min( ndata, (blocks[k].second+1)*bsize );
+    for(unsigned i=blocks[k].first*bsize; i<iend; ++i) {
+      for(unsigned j=std::max( i+1, blocks[k].second*bsize ); j<jend; ++j) {
+        dissimilarities(i,j)=dissimilarities(j,i)=calculateDissimilarity( i, j );
+      }
+    }
   }
+  comm.Sum( dissimilarities.getVector() );
 }
 
 std::string EuclideanDissimilarityMatrix::getDissimilarityInstruction() const {
   return "TYPE=" + mtype;
 }
 
+double EuclideanDissimilarityMatrix::calculateDissimilarity( const unsigned& iframe, const unsigned& jframe ) {
+  return distance( getPbc(), getArguments(), myrefs[iframe].get(), myrefs[jframe].get(), true );
+}
+
 double EuclideanDissimilarityMatrix::getDissimilarity( const unsigned& iframe, const unsigned& jframe ) {
   plumed_dbg_assert( iframe<getNumberOfDataPoints() && jframe<getNumberOfDataPoints() );
-  if( !usingLowMem() ) {
-    if( dissimilarities(iframe,jframe)>0. ) { return dissimilarities(iframe,jframe); }
-  }
-  if( iframe!=jframe ) {
-    double dd;
-    getStoredData( iframe, true ).transferDataToPDB( mypdb );
-    auto myref1=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    getStoredData( jframe, true ).transferDataToPDB( mypdb );
-    auto myref2=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    if( !usingLowMem() ) dd=dissimilarities(iframe,jframe) = dissimilarities(jframe,iframe) = distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    else dd=distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    return dd;
-  }
+  if( !usingLowMem() ) return dissimilarities(iframe,jframe);
+  if( iframe!=jframe ) return calculateDissimilarity( iframe, jframe );
   return 0.0;
 }
 
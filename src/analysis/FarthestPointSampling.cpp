@@ -27,6 +27,14 @@
 /*
 Select a set of landmarks using farthest point sampling.
 
+The minimum distance between each frame and the landmarks selected thus far is stored
+and updated when a new landmark is selected, so that the distance between each landmark and each frame is calculated only once.
+The frames are shared among the OpenMP threads and the MPI processes.
+If the dissimilarity is a metric (as for EUCLIDEAN or OPTIMAL) the PRUNE flag can be used to skip
+the calculation of the distances that, according to the triangle inequality, cannot change the selection.
+This requires the distances between the landmarks, but it avoids most of the distance calculations when many landmarks are selected.
+For dissimilarities that are not metrics the selection obtained with PRUNE is approximate.
+
 \par Examples
 
 */
@@ -38,6 +46,7 @@ namespace analysis {
 class FarthestPointSampling : public LandmarkSelectionBase {
 private:
   unsigned seed;
+  bool prune;
 public:
   static void registerKeywords( Keywords& keys );
   FarthestPointSampling( const ActionOptions& ao );
@@ -49,6 +58,7 @@ PLUMED_REGISTER_ACTION(FarthestPointSampling,"LANDMARK_SELECT_FPS")
 void FarthestPointSampling::registerKeywords( Keywords& keys ) {
   LandmarkSelectionBase::registerKeywords(keys);
   keys.add("compulsory","SEED","1234","a random number seed");
+  keys.addFlag("PRUNE",false,"use the triangle inequality to avoid calculating distances that cannot change the selection");
 }
 
 FarthestPointSampling::FarthestPointSampling( const ActionOptions& ao ):
@@ -56,7 +66,8 @@ FarthestPointSampling::FarthestPointSampling( const ActionOptions& ao ):
   LandmarkSelectionBase(ao)
 {
   if( !dissimilaritiesWereSet() ) error("dissimilarities have not been calcualted in input action");
-  parse("SEED",seed);
+  parse("SEED",seed); parseFlag("PRUNE",prune);
+  if( prune ) log.printf("  using triangle inequality to reduce the number of distances calculated\n");
 }
 
 void FarthestPointSampling::selectLandmarks() {
@@ -65,26 +76,10 @@ void FarthestPointSampling::selectLandmarks() {
   // Select first point at random
   Random random; random.setSeed(-seed); double rand=random.RandU01();
   landmarks[0] = std::floor( my_input_data->getNumberOfDataPoints()*rand );
-  selectFrame( landmarks[0] );
-
-  // Now find distance to all other points (N.B. We can use squared distances here for speed)
-  Matrix<double> distances( getNumberOfDataPoints(), my_input_data->getNumberOfDataPoints() );
-  for(unsigned i=0; i<my_input_data->getNumberOfDataPoints(); ++i) distances(0,i) = my_input_data->getDissimilarity( landmarks[0], i );
-
-  // Now find all other landmarks
-  for(unsigned i=1; i<getNumberOfDataPoints(); ++i) {
-    // Find point that has the largest minimum distance from the landmarks selected thus far
-    double maxd=0;
-    for(unsigned j=0; j<my_input_data->getNumberOfDataPoints(); ++j) {
-      double mind=distances(0,j);
-      for(unsigned k=1; k<i; ++k) {
-        if( distances(k,j)<mind ) { mind=distances(k,j); }
-      }
-      if( mind>maxd ) { maxd=mind; landmarks[i]=j; }
-    }
-    selectFrame( landmarks[i] );
-    for(unsigned k=0; k<my_input_data->getNumberOfDataPoints(); ++k) distances(i,k) = my_input_data->getDissimilarity( landmarks[i], k );
-  }
+
+  // Now find all other landmarks (N.B. We can use squared distances here for speed)
+  selectFarthestPoints( landmarks, prune );
+  for(unsigned i=0; i<landmarks.size(); ++i) selectFrame( landmarks[i] );
 }
 
 }
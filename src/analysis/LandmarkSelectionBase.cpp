@@ -20,6 +20,10 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "LandmarkSelectionBase.h"
+#include "tools/OpenMP.h"
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
 namespace PLMD {
 namespace analysis {
@@ -69,18 +73,67 @@ void LandmarkSelectionBase::voronoiAnalysis( const std::vector<unsigned>& myindi
   plumed_dbg_assert( myindices.size()==lweights.size() && assignments.size()==my_input_data->getNumberOfDataPoints() );
   lweights.assign( lweights.size(), 0 );
   unsigned rank=comm.Get_rank(), size=comm.Get_size();
+  #pragma omp parallel for num_threads(OpenMP::getNumThreads())
   for(unsigned i=rank; i<my_input_data->getNumberOfDataPoints(); i+=size) {
     assignments[i]=0;
     double mindist=my_input_data->getDissimilarity( i, myindices[0] );
-    for(unsigned j=1; j<nlandmarks; ++j) {
+    for(unsigned j=1; j<myindices.size(); ++j) {
       double dist=my_input_data->getDissimilarity( i, myindices[j] );
       if( dist<mindist ) { mindist=dist; assignments[i]=j; }
     }
-    lweights[ assignments[i] ] += my_input_data->getWeight(i);
   }
+  for(unsigned i=rank; i<my_input_data->getNumberOfDataPoints(); i+=size) lweights[ assignments[i] ] += my_input_data->getWeight(i);
   comm.Sum( &lweights[0], lweights.size() );
   comm.Sum( &assignments[0], assignments.size() );
 }
 
+void LandmarkSelectionBase::selectFarthestPoints( std::vector<unsigned>& landmarks, const bool& prune ) const {
+  const unsigned N=my_input_data->getNumberOfDataPoints();
+  // Each process takes care of a contiguous block of frames
+  const unsigned rank=comm.Get_rank(), size=comm.Get_size();
+  const unsigned nblock=(N+size-1)/size, start=std::min(N,rank*nblock), end=std::min(N,start+nblock);
+  // The (squared) distance of each frame from the closest landmark selected thus far and the index of this landmark.
+  // These are updated every time a landmark is added so each distance is only calculated once
+  std::vector<double> mind( end-start, std::numeric_limits<double>::max() );
+  std::vector<unsigned> closest( end-start, 0 );
+  // The distances between the last landmark and the previous ones
+  std::vector<double> ldist;
+  std::vector<double> best( 2*size );
+  const unsigned nt=OpenMP::getNumThreads();
+  for(unsigned i=1; i<landmarks.size(); ++i) {
+    const unsigned newl=landmarks[i-1];
+    if( prune ) {
+      ldist.resize( i-1 );
+      #pragma omp parallel for num_threads(nt)
+      for(unsigned k=0; k<i-1; ++k) ldist[k]=std::sqrt( my_input_data->getDissimilarity( newl, landmarks[k] ) );
+    }
+    // Update the distances and find the point that has the largest minimum distance from the landmarks
+    double maxd=0; unsigned maxj=0;
+    #pragma omp parallel num_threads(nt)
+    {
+      double tmaxd=0; unsigned tmaxj=0;
+      #pragma omp for nowait
+      for(unsigned j=start; j<end; ++j) {
+        double & mj( mind[j-start] );
+        // d(newl,j) >= d(newl,closest) - d(closest,j) >= d(closest,j) so the new landmark cannot be closer
+        if( !prune || i==1 || ldist[closest[j-start]]<2*std::sqrt(mj) ) {
+          double d=my_input_data->getDissimilarity( newl, j );
+          if( d<mj ) { mj=d; closest[j-start]=i-1; }
+        }
+        if( mj>tmaxd ) { tmaxd=mj; tmaxj=j; }
+      }
+      #pragma omp critical
+      if( tmaxd>maxd || (tmaxd>0 && tmaxd==maxd && tmaxj<maxj) ) { maxd=tmaxd; maxj=tmaxj; }
+    }
+    // Find the farthest point among all the processes
+    best.assign( best.size(), 0 ); best[2*rank]=maxd; best[2*rank+1]=maxj;
+    comm.Sum( best );
+    maxd=0; landmarks[i]=0;
+    for(unsigned r=0; r<size; ++r) {
+      if( best[2*r]>maxd ) { maxd=best[2*r]; landmarks[i]=static_cast<unsigned>( best[2*r+1] ); }
+    }
+  }
+}
+
 }
 }
@@ -43,6 +43,9 @@ protected:
   void selectFrame( const unsigned& );
 /// Do a voronoi analysis
   void voronoiAnalysis( const std::vector<unsigned>& myindices, std::vector<double>& lweights, std::vector<unsigned>& assignments ) const ;
+/// Select landmarks using farthest point sampling starting from the one in landmarks[0].
+/// When prune is true the distances that cannot change the selection because of the triangle inequality are not calculated
+  void selectFarthestPoints( std::vector<unsigned>& landmarks, const bool& prune ) const ;
 public:
   static void registerKeywords( Keywords& keys );
   LandmarkSelectionBase( const ActionOptions& ao );
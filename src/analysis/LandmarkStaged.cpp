@@ -41,6 +41,7 @@ class LandmarkStaged : public LandmarkSelectionBase {
 private:
   unsigned seed;
   double gamma;
+  bool prune;
 public:
   static void registerKeywords( Keywords& keys );
   LandmarkStaged( const ActionOptions& ao );
@@ -53,13 +54,14 @@ void LandmarkStaged::registerKeywords( Keywords& keys ) {
   LandmarkSelectionBase::registerKeywords(keys);
   keys.add("compulsory","GAMMA","the gamma parameter to be used in weights");
   keys.add("compulsory","SEED","1234","a random number seed");
+  keys.addFlag("PRUNE",false,"use the triangle inequality to avoid calculating distances that cannot change the farthest point sampling");
 }
 
 LandmarkStaged::LandmarkStaged( const ActionOptions& ao ):
   Action(ao),
   LandmarkSelectionBase(ao)
 {
-  parse("SEED",seed); parse("GAMMA",gamma);
+  parse("SEED",seed); parse("GAMMA",gamma); parseFlag("PRUNE",prune);
   log.printf("  probability of selecting voronoi polyhedra equal to exp(-weight/%f) \n", gamma );
 }
 
@@ -73,25 +75,7 @@ void LandmarkStaged::selectLandmarks() {
   fpslandmarks[0] = std::floor( N*rand );
 
   // using FPS we want to find m landmarks where m = sqrt(nN)
-  // Now find distance to all other points
-  Matrix<double> distances( m, N );
-  for(unsigned int i=0; i<N; ++i) {
-    distances(0,i) = my_input_data->getDissimilarity( fpslandmarks[0], i );
-  }
-
-  // Now find all other landmarks
-  for(unsigned i=1; i<m; ++i) {
-    // Find point that has the largest minimum distance from the landmarks selected thus far
-    double maxd=0;
-    for(unsigned j=0; j<N; ++j) {
-      double mind=distances(0,j);
-      for(unsigned k=1; k<i; ++k) {
-        if( distances(k,j)<mind ) { mind=distances(k,j); }
-      }
-      if( mind>maxd ) { maxd=mind; fpslandmarks[i]=j; }
-    }
-    for(unsigned k=0; k<N; ++k) distances(i,k) = my_input_data->getDissimilarity( fpslandmarks[i], k );
-  }
+  selectFarthestPoints( fpslandmarks, prune );
 
   // Initial FPS selection of m landmarks completed
   // Now find voronoi weights of these m points
@@ -112,13 +96,13 @@ void LandmarkStaged::selectLandmarks() {
       if( running_vweight>=rand ) {
         double tweight=0;
         for(unsigned i=0; i<poly_assign.size(); ++i) {
-          if( poly_assign[i]==jpoly ) tweight += getWeight( i );
+          if( poly_assign[i]==jpoly ) tweight += my_input_data->getWeight( i );
         }
         double rand_poly = tweight*random.RandU01();
         double running_tweight=0;
         for(unsigned i=0; i<N; ++i) {
           if( poly_assign[i]==jpoly ) {
-            running_tweight += getWeight( i );
+            running_tweight += my_input_data->getWeight( i );
             if( running_tweight>=rand_poly && !selected[i] ) {
               selectFrame(i); selected[i]=true; ncount++; break;
             } else if( running_tweight>=rand_poly ) {
@@ -126,6 +110,7 @@ void LandmarkStaged::selectLandmarks() {
             }
           }
         }
+        break;
       }
     }
   }
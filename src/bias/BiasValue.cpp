@@ -79,6 +79,7 @@ PRINT ARG=t,cos,sin,d.x,d.y,d.z,mycos,mysin,cc.bias.vv1 STRIDE=1 FILE=colvar FMT
 class BiasValue : public Bias {
 public:
   explicit BiasValue(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
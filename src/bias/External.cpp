@@ -101,6 +101,7 @@ private:
 
 public:
   explicit External(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -73,6 +73,7 @@ class LWalls : public Bias {
   std::vector<double> offset;
 public:
   explicit LWalls(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
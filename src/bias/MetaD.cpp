@@ -29,9 +29,13 @@
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
 #include "tools/Random.h"
+#include "tools/OpenMP.h"
 #include <string>
 #include <cstring>
+#include <cstdio>
 #include "tools/File.h"
+#include "tools/BinaryHills.h"
+#include "tools/SharedRing.h"
 #include <iostream>
 #include <limits>
 #include <ctime>
@@ -233,6 +237,38 @@ where all the walkers are located. WALKERS_RSTRIDE is the number of step between
 one update and the other. Since version 2.2.5, hills files are automatically
 flushed every WALKERS_RSTRIDE steps.
 
+\par
+When all the walkers run on the same node, reading the hills files of the other walkers
+can be avoided with WALKERS_SHM. The hills are then exchanged through a file mapped in memory
+by all the walkers, which should be on a memory file system such as /dev/shm.
+Each walker sees the hills deposited by the others as soon as it reads them
+(every WALKERS_RSTRIDE steps, by default at every step), without accessing the disk.
+Hills are still written on the hills files, which can be used for restarting.
+The shared memory can store up to WALKERS_SHM_SIZE hills. A walker that does not
+read the hills before they are overwritten stops with an error.
+All the walkers should be started at the same time, and the shared memory file is removed when
+the last walker finishes. If a simulation crashes, the file should be removed by hand.
+\plumedfile
+METAD ...
+   ARG=d1 SIGMA=0.05 HEIGHT=0.3 PACE=500 LABEL=restraint
+   WALKERS_N=10
+   WALKERS_ID=3
+   WALKERS_DIR=../
+   WALKERS_SHM=/dev/shm/my-metad
+... METAD
+\endplumedfile
+
+\par
+Long simulations can deposit millions of hills, and reading them back from a text file
+when restarting, when reading the hills of the other walkers, or with \ref sum_hills can take a long time.
+With the flag BINARY_HILLS the hills are written in a compact binary format that is much faster to read.
+Binary hills files are recognized automatically when reading, and can be converted to text
+and back with \ref convert_hills.
+\plumedfile
+DISTANCE ATOMS=3,5 LABEL=d1
+METAD ARG=d1 SIGMA=0.05 HEIGHT=0.3 PACE=500 FILE=HILLS.bin BINARY_HILLS LABEL=restraint
+\endplumedfile
+
 \par
 The c(t) reweighting factor can be calculated on the fly using the equations
 presented in \cite Tiwary_jp504920s as described above.
@@ -365,6 +401,15 @@ The number of elements in the RECT array should be equal to the number of replic
 */
 //+ENDPLUMEDOC
 
+/// Check if a file is empty
+static bool isEmpty(const std::string & path) {
+  FILE* fp=std::fopen(path.c_str(),"r");
+  if(!fp) return true;
+  bool empty=(std::fgetc(fp)==EOF);
+  std::fclose(fp);
+  return empty;
+}
+
 class MetaD : public Bias {
 
 private:
@@ -396,6 +441,8 @@ private:
   vector<double> sigma0max_;
   vector<Gaussian> hills_;
   OFile hillsOfile_;
+  bool binaryHills_;
+  std::unique_ptr<BinaryHillsWriter> hillsWriter_;
   OFile gridfile_;
   std::unique_ptr<Grid> BiasGrid_;
   bool storeOldGrids_;
@@ -426,6 +473,9 @@ private:
   string mw_dir_;
   int mw_id_;
   int mw_rstride_;
+  string mw_shm_;
+  unsigned mw_shm_size_;
+  std::unique_ptr<SharedRing> mw_ring_;
   bool walkers_mpi;
   unsigned mpi_nw_;
   unsigned mpi_mw_;
@@ -439,6 +489,7 @@ private:
   double transition_bias_;
   vector<vector<double> > transitionwells_;
   vector<std::unique_ptr<IFile>> ifiles;
+  vector<std::unique_ptr<BinaryHillsReader>> breaders;
   vector<string> ifilesnames;
   double uppI_;
   double lowI_;
@@ -454,8 +505,17 @@ private:
   void   readTemperingSpecs(TemperingSpecs &t_specs);
   void   logTemperingSpecs(const TemperingSpecs &t_specs);
   void   readGaussians(IFile*);
+  void   readGaussians(BinaryHillsReader*);
+  void   readGaussians(unsigned i);
   void   writeGaussian(const Gaussian&,OFile&);
+  void   shareGaussian(const Gaussian&);
+  void   readSharedGaussians();
+  vector<string> getHillsFields();
+  vector<std::pair<string,string> > getHillsConstants();
+  Matrix<double> getHillCholesky(const Gaussian&)const;
+  void   getSigmaFromCholesky(const Matrix<double>&,vector<double>&)const;
   void   addGaussian(const Gaussian&);
+  void   addDiagonalGaussian(const Gaussian&);
   double getHeight(const vector<double>&);
   void   temperHeight(double &height, const TemperingSpecs &t_specs, const double tempering_bias);
   double getBiasAndDerivatives(const vector<double>&,double* der=NULL);
@@ -494,6 +554,7 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("compulsory","FILE","HILLS","a file in which the list of added hills is stored");
   keys.add("optional","HEIGHT","the heights of the Gaussian hills. Compulsory unless TAU and either BIASFACTOR or DAMPFACTOR are given");
   keys.add("optional","FMT","specify format for HILLS files (useful for decrease the number of digits in regtests)");
+  keys.addFlag("BINARY_HILLS",false,"write the HILLS file in a binary format that is faster to read when restarting, with multiple walkers and with sum_hills");
   keys.add("optional","BIASFACTOR","use well tempered metadynamics and use this biasfactor.  Please note you must also specify temp");
   keys.add("optional","RECT","list of bias factors for all the replicas");
   keys.add("optional","DAMPFACTOR","damp hills with exp(-max(V)/(kbT*DAMPFACTOR)");
@@ -514,6 +575,7 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","REWEIGHTING_NHILLS","how many Gaussian hills should be deposited between calculating the c(t) reweighting factor."
            "The default is to do this every 50 hills.");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.add("optional","GRID_SPARSE_TILE","the number of consecutive grid points that are stored together in a sparse grid (default 8)");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
   keys.add("optional","GRID_WSTRIDE","write the grid to a file every N steps");
   keys.add("optional","GRID_WFILE","the file on which to write the grid");
@@ -524,6 +586,8 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","WALKERS_N", "number of walkers");
   keys.add("optional","WALKERS_DIR", "shared directory with the hills files from all the walkers");
   keys.add("optional","WALKERS_RSTRIDE","stride for reading hills files");
+  keys.add("optional","WALKERS_SHM","a file in shared memory (e.g. in /dev/shm) used to exchange hills among the walkers running on the same node");
+  keys.add("optional","WALKERS_SHM_SIZE","maximum number of hills stored in the shared memory used with WALKERS_SHM (default 100000)");
   keys.add("optional","INTERVAL","monodimensional lower and upper limits, outside the limits the system will not feel the biasing force.");
   keys.add("optional","SIGMA_MAX","the upper bounds for the sigmas (in CV units) when using adaptive hills. Negative number means no bounds ");
   keys.add("optional","SIGMA_MIN","the lower bounds for the sigmas (in CV units) when using adaptive hills. Negative number means no bounds ");
@@ -553,6 +617,7 @@ void MetaD::registerTemperingKeywords(const std::string &name_stem, const std::s
 
 MetaD::MetaD(const ActionOptions& ao):
   PLUMED_BIAS_INIT(ao),
+  binaryHills_(false),
 // Grid stuff initialization
   wgridstride_(0), grid_(false),
 // Metadynamics basic parameters
@@ -570,6 +635,7 @@ MetaD::MetaD(const ActionOptions& ao):
   adaptive_(FlexibleBin::none),
 // Multiple walkers initialization
   mw_n_(1), mw_dir_(""), mw_id_(0), mw_rstride_(1),
+  mw_shm_(""), mw_shm_size_(100000),
   walkers_mpi(false), mpi_nw_(0), mpi_mw_(0),
 // Flying Gaussian
   flying(false),
@@ -601,6 +667,7 @@ MetaD::MetaD(const ActionOptions& ao):
   }
 
   parse("FMT",fmt);
+  parseFlag("BINARY_HILLS",binaryHills_);
 
   // parse the sigma
   parseVector("SIGMA",sigma0_);
@@ -760,6 +827,9 @@ MetaD::MetaD(const ActionOptions& ao):
   }
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  unsigned sparsetile=Grid::defaultsparsetilesize;
+  parse("GRID_SPARSE_TILE",sparsetile);
+  if(sparsetile==0) error("GRID_SPARSE_TILE should be greater than zero");
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -803,6 +873,8 @@ MetaD::MetaD(const ActionOptions& ao):
   if(mw_n_<=mw_id_) error("walker ID should be a numerical value less than the total number of walkers");
   parse("WALKERS_DIR",mw_dir_);
   parse("WALKERS_RSTRIDE",mw_rstride_);
+  parse("WALKERS_SHM",mw_shm_);
+  parse("WALKERS_SHM_SIZE",mw_shm_size_);
 
   // MPI version
   parseFlag("WALKERS_MPI",walkers_mpi);
@@ -864,6 +936,10 @@ MetaD::MetaD(const ActionOptions& ao):
   log.printf("  Gaussian height %f\n",height0_);
   log.printf("  Gaussian deposition pace %d\n",stride_);
   log.printf("  Gaussian file %s\n",hillsfname.c_str());
+  if(binaryHills_) {
+    log.printf("  Gaussian file is written in binary format\n");
+    if(Tools::extension(hillsfname)=="gz") error("binary hills files cannot be compressed");
+  }
   if(welltemp_) {
     log.printf("  Well-Tempered Bias Factor %f\n",biasf_);
     log.printf("  Hills relaxation time (tau) %f\n",tau);
@@ -937,7 +1013,7 @@ MetaD::MetaD(const ActionOptions& ao):
     for(unsigned i=0; i<gbin.size(); ++i) log.printf(" %u",gbin[i]);
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
-    if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(sparsegrid) {log.printf("  Grid uses sparse grid with tiles of %u points\n",sparsetile);}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
   }
 
@@ -947,7 +1023,14 @@ MetaD::MetaD(const ActionOptions& ao):
     log.printf("  walker id %d\n",mw_id_);
     log.printf("  reading stride %d\n",mw_rstride_);
     if(mw_dir_!="")log.printf("  directory with hills files %s\n",mw_dir_.c_str());
+    if(mw_shm_!="") {
+      if(!SharedRing::isAvailable()) error("WALKERS_SHM is not available on this machine");
+      if(mw_shm_size_==0) error("WALKERS_SHM_SIZE should be positive");
+      log.printf("  hills are exchanged through shared memory file %s\n",mw_shm_.c_str());
+      log.printf("  up to %u hills are stored in shared memory\n",mw_shm_size_);
+    }
   } else {
+    if(mw_shm_!="") error("WALKERS_SHM can only be used with WALKERS_N");
     if(walkers_mpi) {
       log.printf("  Multiple walkers active using MPI communnication\n");
       if(mw_dir_!="")log.printf("  directory with hills files %s\n",mw_dir_.c_str());
@@ -1092,7 +1175,7 @@ MetaD::MetaD(const ActionOptions& ao):
     }
     std::string funcl=getLabel() + ".bias";
     if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
-    else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true,sparsetile));}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
     for(unsigned i=0; i<getNumberOfArguments(); i++) {
@@ -1115,7 +1198,7 @@ MetaD::MetaD(const ActionOptions& ao):
       error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
     }
     std::string funcl=getLabel() + ".bias";
-    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+    BiasGrid_=Grid::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true, sparsetile);
     if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
     for(unsigned i=0; i<getNumberOfArguments(); ++i) {
       if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -1143,7 +1226,7 @@ MetaD::MetaD(const ActionOptions& ao):
     }
     std::string funcl=getLabel() + ".bias";
     if(!sparsegrid) {BiasGrid_.reset(new Grid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
-    else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true));}
+    else {BiasGrid_.reset(new SparseGrid(funcl,getArguments(),gmin,gmax,gbin,spline,true,sparsetile));}
     std::vector<std::string> actualmin=BiasGrid_->getMin();
     std::vector<std::string> actualmax=BiasGrid_->getMax();
     for(unsigned i=0; i<getNumberOfArguments(); i++) {
@@ -1154,6 +1237,7 @@ MetaD::MetaD(const ActionOptions& ao):
 
   // creating vector of ifile* for hills reading
   // open all files at the beginning and read Gaussians if restarting
+  bool appendBinaryHills=false;
   for(int i=0; i<mw_n_; ++i) {
     string fname;
     if(mw_dir_!="") {
@@ -1174,20 +1258,31 @@ MetaD::MetaD(const ActionOptions& ao):
       }
     }
     ifiles.emplace_back(new IFile());
+    breaders.emplace_back();
     // this is just a shortcut pointer to the last element:
     IFile *ifile = ifiles.back().get();
     ifilesnames.push_back(fname);
     ifile->link(*this);
-    if(ifile->FileExist(fname)) {
+    const bool exists=ifile->FileExist(fname);
+    // the files of the other walkers are opened only once their format can be read from their content
+    if(exists && (i==mw_id_ || !isEmpty(ifile->getPath()))) {
+      const bool empty=isEmpty(ifile->getPath());
+      if(BinaryHillsReader::isBinary(ifile->getPath()) || (empty && binaryHills_)) breaders[i].reset(new BinaryHillsReader(*ifile));
+      // when restarting the new hills are appended to the existing file
+      if(i==mw_id_ && getRestart()) {
+        if(!empty && binaryHills_ && !breaders[i]) error("cannot append binary hills to the text file "+fname+" (see convert_hills)");
+        if(!empty && !binaryHills_ && breaders[i]) error("cannot append text hills to the binary file "+fname+" (see convert_hills)");
+        appendBinaryHills=binaryHills_ && !empty;
+      }
       ifile->open(fname);
       if(getRestart()&&!restartedFromGrid) {
         log.printf("  Restarting from %s:",ifilesnames[i].c_str());
-        readGaussians(ifiles[i].get());
+        readGaussians(i);
       }
       ifiles[i]->reset(false);
       // close only the walker own hills file for later writing
       if(i==mw_id_) ifiles[i]->close();
-    } else {
+    } else if(!exists) {
       // in case a file does not exist and we are restarting, complain that the file was not found
       if(getRestart()) log<<"  WARNING: restart file "<<fname<<" not found\n";
     }
@@ -1202,6 +1297,12 @@ MetaD::MetaD(const ActionOptions& ao):
   // (e.g. in bias exchange with a neutral replica)
   // see issue #168 on github
   if(comm.Get_rank()==0 && walkers_mpi) multi_sim_comm.Barrier();
+  // the shared memory is only accessed by the root of each walker
+  if(mw_shm_!="" && comm.Get_rank()==0) {
+    const unsigned ncv=getNumberOfArguments();
+    mw_ring_.reset(new SharedRing);
+    mw_ring_->open(mw_shm_,3+ncv+ncv*(ncv+1)/2,mw_shm_size_);
+  }
   if(targetfilename_.length()>0) {
     IFile gridfile; gridfile.open(targetfilename_);
     std::string funcl=getLabel() + ".target";
@@ -1247,6 +1348,15 @@ MetaD::MetaD(const ActionOptions& ao):
     if(r>0) ifilesnames[mw_id_]="/dev/null";
     hillsOfile_.enforceSuffix("");
   }
+  if(appendBinaryHills && ifilesnames[mw_id_]!="/dev/null") {
+    // records are appended to an existing binary file only if they have the same layout
+    IFile ifile; ifile.link(*this);
+    ifile.open(ifilesnames[mw_id_]);
+    BinaryHillsReader reader(ifile);
+    if(!reader.readHeader()) error("incomplete header in binary hills file "+ifilesnames[mw_id_]);
+    if(reader.getFields()!=getHillsFields() || reader.getConstants()!=getHillsConstants())
+      error("the fields of binary hills file "+ifilesnames[mw_id_]+" do not match the ones of this METAD, new hills cannot be appended");
+  }
   if(mw_n_>1) hillsOfile_.enforceSuffix("");
   hillsOfile_.open(ifilesnames[mw_id_]);
   if(fmt.length()>0) hillsOfile_.fmtField(fmt);
@@ -1259,6 +1369,10 @@ MetaD::MetaD(const ActionOptions& ao):
   hillsOfile_.setHeavyFlush();
   // output periodicities of variables
   for(unsigned i=0; i<getNumberOfArguments(); ++i) hillsOfile_.setupPrintValue( getPntrToArgument(i) );
+  if(binaryHills_) {
+    hillsWriter_.reset(new BinaryHillsWriter(hillsOfile_,getHillsFields(),getHillsConstants()));
+    if(!appendBinaryHills) hillsWriter_->writeHeader();
+  }
 
   bool concurrent=false;
   const ActionSet&actionSet(plumed.getActionSet());
@@ -1355,38 +1469,193 @@ void MetaD::readGaussians(IFile *ifile)
   log.printf("      %d Gaussians read\n",nhills);
 }
 
-void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
+void MetaD::readGaussians(unsigned i)
+{
+  if(breaders[i]) readGaussians(breaders[i].get());
+  else readGaussians(ifiles[i].get());
+}
+
+void MetaD::readGaussians(BinaryHillsReader *reader)
 {
   unsigned ncv=getNumberOfArguments();
-  file.printField("time",getTimeStep()*getStep());
+  vector<double> center(ncv);
+  vector<double> sigma(ncv);
+  vector<double> record;
+  int nhills=0;
+  // the header might not be complete yet if another walker is writing it
+  if(!reader->readHeader()) {
+    log.printf("      %d Gaussians read\n",nhills);
+    return;
+  }
   for(unsigned i=0; i<ncv; ++i) {
-    file.printField(getPntrToArgument(i),hill.center[i]);
+    const string name=getPntrToArgument(i)->getName();
+    bool periodic=reader->constantExist("min_"+name);
+    if(periodic!=getPntrToArgument(i)->isPeriodic()) error("in hills file periodicity for variable " + name + " does not match periodicity in input");
+    if(periodic) {
+      std::string rmin, rmax; getPntrToArgument(i)->getDomain( rmin, rmax );
+      if(reader->getConstant("min_"+name)!=rmin || reader->getConstant("max_"+name)!=rmax) {
+        error("in hills file periodicity for variable " + name + " does not match periodicity in input");
+      }
+    }
   }
-  hillsOfile_.printField("kerneltype","gaussian");
-  if(hill.multivariate) {
-    hillsOfile_.printField("multivariate","true");
-    Matrix<double> mymatrix(ncv,ncv);
-    unsigned k=0;
+  const string sss=reader->getConstant("multivariate");
+  if(sss!="true" && sss!="false") plumed_merror("cannot parse multivariate = "+ sss);
+  const bool multivariate=(sss=="true");
+  // position of the fields in each record
+  vector<unsigned> icenter(ncv), isigma;
+  for(unsigned i=0; i<ncv; ++i) icenter[i]=reader->getFieldIndex(getPntrToArgument(i)->getName());
+  if(multivariate) {
     for(unsigned i=0; i<ncv; i++) {
-      for(unsigned j=i; j<ncv; j++) {
-        // recompose the full inverse matrix
-        mymatrix(i,j)=mymatrix(j,i)=hill.sigma[k];
-        k++;
+      for(unsigned j=0; j<ncv-i; j++) isigma.push_back(reader->getFieldIndex("sigma_"+getPntrToArgument(j+i)->getName()+"_"+getPntrToArgument(j)->getName()));
+    }
+  } else {
+    for(unsigned i=0; i<ncv; ++i) isigma.push_back(reader->getFieldIndex("sigma_"+getPntrToArgument(i)->getName()));
+  }
+  const unsigned iheight=reader->getFieldIndex("height");
+  Matrix<double> lower(ncv,ncv);
+
+  while(reader->readRecord(record)) {
+    for(unsigned i=0; i<ncv; ++i) center[i]=record[icenter[i]];
+    if(multivariate) {
+      unsigned k=0;
+      for(unsigned i=0; i<ncv; i++) {
+        for(unsigned j=0; j<ncv-i; j++) {lower(j+i,j)=record[isigma[k]]; k++;}
       }
+      getSigmaFromCholesky(lower,sigma);
+    } else {
+      for(unsigned i=0; i<ncv; ++i) sigma[i]=record[isigma[i]];
     }
-    // invert it
-    Matrix<double> invmatrix(ncv,ncv);
-    Invert(mymatrix,invmatrix);
-    // enforce symmetry
+    double height=record[iheight];
+    nhills++;
+// note that for gamma=1 we store directly -F
+    if(welltemp_ && biasf_>1.0) {height*=(biasf_-1.0)/biasf_;}
+    addGaussian(Gaussian(center,sigma,height,multivariate));
+  }
+  log.printf("      %d Gaussians read\n",nhills);
+}
+
+vector<string> MetaD::getHillsFields()
+{
+  unsigned ncv=getNumberOfArguments();
+  vector<string> fields;
+  fields.push_back("time");
+  for(unsigned i=0; i<ncv; ++i) fields.push_back(getPntrToArgument(i)->getName());
+  if(adaptive_!=FlexibleBin::none) {
     for(unsigned i=0; i<ncv; i++) {
-      for(unsigned j=i; j<ncv; j++) {
-        invmatrix(i,j)=invmatrix(j,i);
-      }
+      for(unsigned j=0; j<ncv-i; j++) fields.push_back("sigma_"+getPntrToArgument(j+i)->getName()+"_"+getPntrToArgument(j)->getName());
+    }
+  } else {
+    for(unsigned i=0; i<ncv; ++i) fields.push_back("sigma_"+getPntrToArgument(i)->getName());
+  }
+  fields.push_back("height");
+  fields.push_back("biasf");
+  if(mw_n_>1) fields.push_back("clock");
+  return fields;
+}
+
+vector<std::pair<string,string> > MetaD::getHillsConstants()
+{
+  vector<std::pair<string,string> > constants;
+  constants.push_back(std::pair<string,string>("multivariate",(adaptive_!=FlexibleBin::none?"true":"false")));
+  constants.push_back(std::pair<string,string>("kerneltype","gaussian"));
+  if(doInt_) {
+    string s;
+    Tools::convert(lowI_,s); constants.push_back(std::pair<string,string>("lower_int",s));
+    Tools::convert(uppI_,s); constants.push_back(std::pair<string,string>("upper_int",s));
+  }
+  for(unsigned i=0; i<getNumberOfArguments(); ++i) {
+    if(!getPntrToArgument(i)->isPeriodic()) continue;
+    string min,max; getPntrToArgument(i)->getDomain(min,max);
+    constants.push_back(std::pair<string,string>("min_"+getPntrToArgument(i)->getName(),min));
+    constants.push_back(std::pair<string,string>("max_"+getPntrToArgument(i)->getName(),max));
+  }
+  return constants;
+}
+
+Matrix<double> MetaD::getHillCholesky(const Gaussian& hill)const
+{
+  unsigned ncv=getNumberOfArguments();
+  Matrix<double> mymatrix(ncv,ncv);
+  unsigned k=0;
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=i; j<ncv; j++) {
+      // recompose the full inverse matrix
+      mymatrix(i,j)=mymatrix(j,i)=hill.sigma[k];
+      k++;
+    }
+  }
+  // invert it
+  Matrix<double> invmatrix(ncv,ncv);
+  Invert(mymatrix,invmatrix);
+  // enforce symmetry
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=i; j<ncv; j++) {
+      invmatrix(i,j)=invmatrix(j,i);
+    }
+  }
+
+  // do cholesky so to have a "sigma like" number
+  Matrix<double> lower(ncv,ncv);
+  cholesky(invmatrix,lower);
+  return lower;
+}
+
+void MetaD::getSigmaFromCholesky(const Matrix<double>& lower,vector<double>& sigma)const
+{
+  unsigned ncv=getNumberOfArguments();
+  sigma.resize(ncv*(ncv+1)/2);
+  Matrix<double> upper(ncv,ncv);
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=0; j<ncv-i; j++) upper(j,j+i)=lower(j+i,j);
+  }
+  Matrix<double> mymult(ncv,ncv);
+  Matrix<double> invmatrix(ncv,ncv);
+  mult(lower,upper,mymult);
+  // now invert and get the sigmas
+  Invert(mymult,invmatrix);
+  // put the sigmas in the usual order: upper diagonal (this time in normal form and not in band form)
+  unsigned k=0;
+  for(unsigned i=0; i<ncv; i++) {
+    for(unsigned j=i; j<ncv; j++) {
+      sigma[k]=invmatrix(i,j);
+      k++;
     }
+  }
+}
 
-    // do cholesky so to have a "sigma like" number
-    Matrix<double> lower(ncv,ncv);
-    cholesky(invmatrix,lower);
+void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
+{
+  unsigned ncv=getNumberOfArguments();
+  if(hillsWriter_) {
+    if(hill.multivariate!=(adaptive_!=FlexibleBin::none)) plumed_merror("binary hills files cannot contain both multivariate and diagonal hills");
+    vector<double> record;
+    record.push_back(getTimeStep()*getStep());
+    for(unsigned i=0; i<ncv; ++i) record.push_back(hill.center[i]);
+    if(hill.multivariate) {
+      Matrix<double> lower=getHillCholesky(hill);
+      for(unsigned i=0; i<ncv; i++) {
+        for(unsigned j=0; j<ncv-i; j++) record.push_back(lower(j+i,j));
+      }
+    } else {
+      for(unsigned i=0; i<ncv; ++i) record.push_back(hill.sigma[i]);
+    }
+    double height=hill.height;
+// note that for gamma=1 we store directly -F
+    if(welltemp_ && biasf_>1.0) height*=biasf_/(biasf_-1.0);
+    record.push_back(height);
+    record.push_back(biasf_);
+    if(mw_n_>1) record.push_back(int(std::time(0)));
+    hillsWriter_->writeRecord(record);
+    return;
+  }
+  file.printField("time",getTimeStep()*getStep());
+  for(unsigned i=0; i<ncv; ++i) {
+    file.printField(getPntrToArgument(i),hill.center[i]);
+  }
+  hillsOfile_.printField("kerneltype","gaussian");
+  if(hill.multivariate) {
+    hillsOfile_.printField("multivariate","true");
+    Matrix<double> lower=getHillCholesky(hill);
     // loop in band form
     for(unsigned i=0; i<ncv; i++) {
       for(unsigned j=0; j<ncv-i; j++) {
@@ -1409,6 +1678,7 @@ void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
 void MetaD::addGaussian(const Gaussian& hill)
 {
   if(!grid_) hills_.push_back(hill);
+  else if(!hill.multivariate && !doInt_) addDiagonalGaussian(hill);
   else {
     unsigned ncv=getNumberOfArguments();
     vector<unsigned> nneighb=getGaussianSupport(hill);
@@ -1444,6 +1714,88 @@ void MetaD::addGaussian(const Gaussian& hill)
   }
 }
 
+// A diagonal hill is the product of one dimensional Gaussians, so the kernel
+// is tabulated once per dimension over the support and the support box is then
+// swept row by row, the first grid index being the contiguous one.
+void MetaD::addDiagonalGaussian(const Gaussian& hill)
+{
+  const unsigned ncv=getNumberOfArguments();
+  const vector<unsigned> nneighb=getGaussianSupport(hill);
+  const vector<unsigned> nbin=BiasGrid_->getNbin();
+  const vector<bool> pbc=BiasGrid_->getIsPeriodic();
+  const vector<unsigned> center=BiasGrid_->getIndices(hill.center);
+
+// per dimension: grid index, squared scaled distance, Gaussian factor and derivative factor
+  vector<vector<unsigned> > gindex(ncv);
+  vector<vector<double> > gdp2(ncv), gfact(ncv), gdfact(ncv);
+  vector<unsigned> indices(center);
+  vector<double> xx(ncv);
+  for(unsigned j=0; j<ncv; ++j) {
+    const int n=static_cast<int>(nbin[j]);
+    for(int k=-static_cast<int>(nneighb[j]); k<=static_cast<int>(nneighb[j]); ++k) {
+      int i0=static_cast<int>(center[j])+k;
+      if(!pbc[j] && (i0<0 || i0>=n)) continue;
+      if(pbc[j]) i0=((i0%n)+n)%n;
+      indices[j]=static_cast<unsigned>(i0);
+      BiasGrid_->getPoint(indices,xx);
+      const double dp=difference(j,hill.center[j],xx[j])*hill.invsigma[j];
+      gindex[j].push_back(indices[j]);
+      gdp2[j].push_back(dp*dp);
+      gfact[j].push_back(exp(-0.5*dp*dp));
+      gdfact[j].push_back(-dp*hill.invsigma[j]);
+    }
+    indices[j]=center[j];
+    if(gindex[j].empty()) return;
+  }
+
+// offsets of the first grid point of each row of the support box
+  const unsigned nrow=gindex[0].size();
+  Grid::index_t ncol=1;
+  for(unsigned j=1; j<ncv; ++j) ncol*=gindex[j].size();
+  const Grid::index_t npoints=ncol*nrow;
+  vector<Grid::index_t> neighbors(npoints);
+  vector<double> allbias(npoints,0.0);
+  vector<double> allder(ncv*npoints,0.0);
+
+  const unsigned stride=comm.Get_size();
+  const unsigned rank=comm.Get_rank();
+  #pragma omp parallel num_threads(OpenMP::getNumThreads())
+  {
+    vector<double> rowder(ncv);
+    #pragma omp for
+    for(Grid::index_t icol=0; icol<ncol; ++icol) {
+      Grid::index_t kk=icol, offset=0, gstride=nbin[0];
+      double rowfact=hill.height, rowdp2=0.0;
+      for(unsigned j=1; j<ncv; ++j) {
+        const unsigned k=kk%gindex[j].size(); kk/=gindex[j].size();
+        offset+=gstride*gindex[j][k]; gstride*=nbin[j];
+        rowfact*=gfact[j][k]; rowdp2+=gdp2[j][k]; rowder[j]=gdfact[j][k];
+      }
+      Grid::index_t* pindex=&neighbors[icol*nrow];
+      const unsigned* pgindex=&gindex[0][0];
+      for(unsigned i=0; i<nrow; ++i) pindex[i]=offset+pgindex[i];
+      if(icol%stride!=rank) continue;
+      double* pbias=&allbias[icol*nrow];
+      double* pder=&allder[ncv*icol*nrow];
+      const double* pdp2=&gdp2[0][0];
+      const double* pfact=&gfact[0][0];
+      const double* pdfact=&gdfact[0][0];
+      for(unsigned i=0; i<nrow; ++i) {
+        if(0.5*(pdp2[i]+rowdp2)>=DP2CUTOFF) continue;
+        const double bias=rowfact*pfact[i];
+        pbias[i]=bias;
+        pder[ncv*i]=bias*pdfact[i];
+        for(unsigned j=1; j<ncv; ++j) pder[ncv*i+j]=bias*rowder[j];
+      }
+    }
+  }
+  if(stride>1) {
+    comm.Sum(allbias);
+    comm.Sum(allder);
+  }
+  BiasGrid_->addValuesAndDerivatives(neighbors,allbias,allder);
+}
+
 vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
 {
   vector<unsigned> nneigh;
@@ -1786,6 +2138,8 @@ void MetaD::update() {
       addGaussian(newhill);
       // print on HILLS file
       writeGaussian(newhill,hillsOfile_);
+      // make it visible to the other walkers
+      if(mw_shm_!="") shareGaussian(newhill);
     }
   }
 
@@ -1824,21 +2178,26 @@ void MetaD::update() {
   }
 
   // if multiple walkers and time to read Gaussians
-  if(mw_n_>1 && getStep()%mw_rstride_==0) {
+  if(mw_n_>1 && getStep()%mw_rstride_==0 && mw_shm_!="") {
+    readSharedGaussians();
+  } else if(mw_n_>1 && getStep()%mw_rstride_==0) {
     for(int i=0; i<mw_n_; ++i) {
       // don't read your own Gaussians
       if(i==mw_id_) continue;
       // if the file is not open yet
       if(!(ifiles[i]->isOpen())) {
-        // check if it exists now and open it!
-        if(ifiles[i]->FileExist(ifilesnames[i])) {
+        // check if it exists now and open it! The format is read from the content of the file,
+        // since the other walkers might write text hills, so empty files are left for the next time
+        if(ifiles[i]->FileExist(ifilesnames[i]) && !isEmpty(ifiles[i]->getPath())) {
+          if(BinaryHillsReader::isBinary(ifiles[i]->getPath())) breaders[i].reset(new BinaryHillsReader(*ifiles[i]));
           ifiles[i]->open(ifilesnames[i]);
           ifiles[i]->reset(false);
         }
-        // otherwise read the new Gaussians
-      } else {
+      }
+      // read the new Gaussians, including those already present in a file that has just been opened
+      if(ifiles[i]->isOpen()) {
         log.printf("  Reading hills from %s:",ifilesnames[i].c_str());
-        readGaussians(ifiles[i].get());
+        readGaussians(i);
         ifiles[i]->reset(false);
       }
     }
@@ -1862,6 +2221,51 @@ void MetaD::update() {
 
 }
 
+void MetaD::shareGaussian(const Gaussian& hill)
+{
+  if(!mw_ring_) return;
+  unsigned ncv=getNumberOfArguments();
+  // record is walker id, multivariate, height, center and sigma
+  vector<double> record(mw_ring_->getRecordSize(),0.0);
+  record[0]=mw_id_;
+  record[1]=(hill.multivariate?1.0:0.0);
+// notice that if gamma=1 we store directly -F so this scaling is not necessary:
+  record[2]=hill.height*(biasf_>1.0?biasf_/(biasf_-1.0):1.0);
+  for(unsigned i=0; i<ncv; ++i) record[3+i]=hill.center[i];
+  for(unsigned i=0; i<hill.sigma.size(); ++i) record[3+ncv+i]=hill.sigma[i];
+  mw_ring_->append(record);
+}
+
+void MetaD::readSharedGaussians()
+{
+  unsigned ncv=getNumberOfArguments();
+  const unsigned rsize=3+ncv+ncv*(ncv+1)/2;
+  // only the root reads the shared memory, so that all the processes see the same hills
+  vector<double> buffer;
+  if(mw_ring_) {
+    vector<double> record;
+    while(mw_ring_->read(record)) {
+      // don't read your own Gaussians
+      if(int(record[0])!=mw_id_) buffer.insert(buffer.end(),record.begin(),record.end());
+    }
+  }
+  unsigned n=buffer.size();
+  comm.Bcast(n,0);
+  if(n==0) return;
+  buffer.resize(n);
+  comm.Bcast(buffer,0);
+  vector<double> center(ncv);
+  for(unsigned k=0; k<n; k+=rsize) {
+    const bool multivariate=(buffer[k+1]>0.5);
+// notice that if gamma=1 we store directly -F so this scaling is not necessary:
+    const double height=buffer[k+2]*(biasf_>1.0?(biasf_-1.0)/biasf_:1.0);
+    for(unsigned i=0; i<ncv; ++i) center[i]=buffer[k+3+i];
+    vector<double> sigma(multivariate?ncv*(ncv+1)/2:ncv);
+    for(unsigned i=0; i<sigma.size(); ++i) sigma[i]=buffer[k+3+ncv+i];
+    addGaussian(Gaussian(center,sigma,height,multivariate));
+  }
+}
+
 /// takes a pointer to the file and a template string with values v and gives back the next center, sigma and height
 bool MetaD::scanOneHill(IFile *ifile,  vector<Value> &tmpvalues, vector<double> &center, vector<double>  &sigma, double &height, bool &multivariate)
 {
@@ -1892,28 +2296,13 @@ bool MetaD::scanOneHill(IFile *ifile,  vector<Value> &tmpvalues, vector<double>
     else if(sss=="false") multivariate=false;
     else plumed_merror("cannot parse multivariate = "+ sss);
     if(multivariate) {
-      sigma.resize(ncv*(ncv+1)/2);
-      Matrix<double> upper(ncv,ncv);
       Matrix<double> lower(ncv,ncv);
       for(unsigned i=0; i<ncv; i++) {
         for(unsigned j=0; j<ncv-i; j++) {
           ifile->scanField("sigma_"+getPntrToArgument(j+i)->getName()+"_"+getPntrToArgument(j)->getName(),lower(j+i,j));
-          upper(j,j+i)=lower(j+i,j);
-        }
-      }
-      Matrix<double> mymult(ncv,ncv);
-      Matrix<double> invmatrix(ncv,ncv);
-      mult(lower,upper,mymult);
-      // now invert and get the sigmas
-      Invert(mymult,invmatrix);
-      // put the sigmas in the usual order: upper diagonal (this time in normal form and not in band form)
-      unsigned k=0;
-      for(unsigned i=0; i<ncv; i++) {
-        for(unsigned j=i; j<ncv; j++) {
-          sigma[k]=invmatrix(i,j);
-          k++;
         }
       }
+      getSigmaFromCholesky(lower,sigma);
     } else {
       for(unsigned i=0; i<ncv; ++i) {
         ifile->scanField("sigma_"+getPntrToArgument(i)->getName(),sigma[i]);
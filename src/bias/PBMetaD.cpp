@@ -305,6 +305,7 @@ void PBMetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","GRID_BIN","the number of bins for the grid");
   keys.add("optional","GRID_SPACING","the approximate grid spacing (to be used as an alternative or together with GRID_BIN)");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.add("optional","GRID_SPARSE_TILE","the number of consecutive grid points that are stored together in a sparse grid (default 8)");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
   keys.add("optional","SELECTOR", "add forces and do update based on the value of SELECTOR");
   keys.add("optional","SELECTOR_ID", "value of SELECTOR");
@@ -501,6 +502,9 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
   }
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  unsigned sparsetile=Grid::defaultsparsetilesize;
+  parse("GRID_SPARSE_TILE",sparsetile);
+  if(sparsetile==0) error("GRID_SPARSE_TILE should be greater than zero");
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -587,7 +591,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
     for(unsigned i=0; i<gbin.size(); ++i) log.printf(" %u",gbin[i]);
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
-    if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(sparsegrid) {log.printf("  Grid uses sparse grid with tiles of %u points\n",sparsetile);}
     if(wgridstride_>0) {
       for(unsigned i=0; i<gridfilenames_.size(); ++i) {
         log.printf("  Grid is written on file %s with stride %d\n",gridfilenames_[i].c_str(),wgridstride_);
@@ -641,7 +645,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
           error("The GRID file you want to read: " + gridreadfilenames_[i] + ", cannot be found!");
         }
         string funcl = getLabel() + ".bias";
-        BiasGrid_=Grid::create(funcl, args, gridfile, gmin_t, gmax_t, gbin_t, sparsegrid, spline, true);
+        BiasGrid_=Grid::create(funcl, args, gridfile, gmin_t, gmax_t, gbin_t, sparsegrid, spline, true, sparsetile);
         if(BiasGrid_->getDimension() != args.size()) {
           error("mismatch between dimensionality of input grid and number of arguments");
         }
@@ -652,7 +656,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
         if(getRestart()) restartedFromGrid=true;
       } else {
         if(!sparsegrid) {BiasGrid_.reset( new Grid(funcl,args,gmin_t,gmax_t,gbin_t,spline,true) );}
-        else           {BiasGrid_.reset( new SparseGrid(funcl,args,gmin_t,gmax_t,gbin_t,spline,true) );}
+        else           {BiasGrid_.reset( new SparseGrid(funcl,args,gmin_t,gmax_t,gbin_t,spline,true,sparsetile) );}
         std::vector<std::string> actualmin=BiasGrid_->getMin();
         std::vector<std::string> actualmax=BiasGrid_->getMax();
         std::string is;
@@ -67,6 +67,7 @@ class Restraint : public Bias {
   Value* valueForce2;
 public:
   explicit Restraint(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
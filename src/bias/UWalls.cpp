@@ -72,6 +72,7 @@ class UWalls : public Bias {
   std::vector<double> offset;
 public:
   explicit UWalls(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -0,0 +1,163 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "tools/Tools.h"
+#include "tools/IFile.h"
+#include "tools/OFile.h"
+#include "tools/BinaryHills.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS convert_hills
+/*
+Convert a hills file between the text and the binary formats.
+
+Hills files written by \ref METAD with the BINARY_HILLS flag are much faster to read
+than text files when restarting, when reading the hills of other walkers, or when using \ref sum_hills.
+This tool converts a binary hills file to text, so that it can be inspected or processed with other tools,
+and a text hills file to binary, so that a simulation started with a text file can be continued in binary format.
+The direction of the conversion is decided by looking at the input file.
+
+A binary hills file contains the same FIELDS and SET lines as the corresponding text file,
+followed by the values of all the fields of each hill as double precision numbers.
+Binary files can only be read on machines with the same endianness as the machine that wrote them.
+
+\par Examples
+
+\verbatim
+plumed convert_hills --hills HILLS.bin --outfile HILLS
+plumed convert_hills --hills HILLS --outfile HILLS.bin
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class ConvertHills:
+  public CLTool
+{
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit ConvertHills(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc);
+  string description()const {
+    return "convert a hills file between the text and the binary formats";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(ConvertHills,"convert_hills")
+
+void ConvertHills::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--hills","the input hills file");
+  keys.add("compulsory","--outfile","the output hills file");
+  keys.add("optional","--fmt","the format that should be used for real numbers when writing a text file");
+}
+
+ConvertHills::ConvertHills(const CLToolOptions& co ):
+  CLTool(co)
+{
+  inputdata=commandline;
+}
+
+int ConvertHills::main(FILE* in, FILE*out,Communicator& pc) {
+  string hills; parse("--hills",hills);
+  string outfile; parse("--outfile",outfile);
+  string fmt; parse("--fmt",fmt);
+
+  IFile ifile;
+  if(!ifile.FileExist(hills)) error("cannot find file "+hills);
+  const bool binary=BinaryHillsReader::isBinary(ifile.getPath());
+  ifile.open(hills);
+  OFile ofile;
+  ofile.open(outfile);
+  unsigned long nhills=0;
+
+  if(binary) {
+    fprintf(out,"Converting binary hills file %s to text file %s\n",hills.c_str(),outfile.c_str());
+    BinaryHillsReader reader(ifile);
+    if(!reader.readHeader()) error("incomplete header in file "+hills);
+    if(fmt.length()>0) ofile.fmtField(fmt);
+    const std::vector<std::string> & fields(reader.getFields());
+    for(const auto & c : reader.getConstants()) ofile.addConstantField(c.first);
+    std::vector<double> record;
+    while(reader.readRecord(record)) {
+      for(unsigned i=0; i<fields.size(); i++) ofile.printField(fields[i],record[i]);
+      for(const auto & c : reader.getConstants()) ofile.printField(c.first,c.second);
+      ofile.printField();
+      nhills++;
+    }
+  } else {
+    fprintf(out,"Converting text hills file %s to binary file %s\n",hills.c_str(),outfile.c_str());
+    std::vector<std::string> fields;
+    std::vector<std::pair<std::string,std::string> > constants;
+    std::unique_ptr<BinaryHillsWriter> writer;
+    std::vector<double> record;
+    std::string line;
+    while(ifile.getline(line)) {
+      std::vector<std::string> words=Tools::getWords(line);
+      if(words.empty()) continue;
+      if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
+        std::vector<std::string> ff(words.begin()+2,words.end());
+        if(writer && ff!=fields) error("the fields change in the middle of file "+hills+", it cannot be converted");
+        fields=ff;
+      } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
+        bool found=false;
+        for(auto & c : constants) if(c.first==words[2]) {
+            if(writer && c.second!=words[3]) error("field "+words[2]+" changes in the middle of file "+hills+", it cannot be converted");
+            c.second=words[3];
+            found=true;
+          }
+        if(!found) {
+          if(writer) error("field "+words[2]+" appears in the middle of file "+hills+", it cannot be converted");
+          constants.push_back(std::pair<std::string,std::string>(words[2],words[3]));
+        }
+      } else if(words[0][0]!='#') {
+        if(words.size()!=fields.size()) error("mismatch between number of fields in file "+hills+" and expected number");
+        if(!writer) {
+          writer.reset(new BinaryHillsWriter(ofile,fields,constants));
+          writer->writeHeader();
+        }
+        record.resize(fields.size());
+        for(unsigned i=0; i<fields.size(); i++) {
+          if(!Tools::convert(words[i],record[i])) error("cannot convert field "+fields[i]+" = "+words[i]+" to a number");
+        }
+        writer->writeRecord(record);
+        nhills++;
+      }
+    }
+  }
+  fprintf(out,"%lu hills converted\n",nhills);
+  ofile.close();
+  ifile.close();
+  return 0;
+}
+
+}
+}
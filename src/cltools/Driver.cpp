@@ -23,14 +23,24 @@
 #include "CLToolRegister.h"
 #include "tools/Tools.h"
 #include "core/PlumedMain.h"
+#include "core/ActionSet.h"
 #include "tools/Communicator.h"
 #include "tools/Random.h"
 #include "tools/Pbc.h"
+#include "tools/OpenMP.h"
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
+#include <cctype>
 #include <vector>
 #include <map>
 #include <memory>
+#include <exception>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "tools/Units.h"
 #include "tools/PDB.h"
 #include "tools/FileBase.h"
@@ -143,6 +153,23 @@ and the `--timestep` is equal to the simulation timestep.  As such the `STRIDE`
 files are referred to the original timestep and any files output resemble those that would have been generated
 had we run the calculation we are running with driver when the MD simulation was running.
 
+Frames of xyz and gro files are read in large blocks and the lines describing the atoms
+are parsed in parallel using the number of threads set with the environment variable `PLUMED_NUM_THREADS`.
+Reading is done in a separate thread, that parses the next few frames while the current one is analyzed.
+
+When all the actions in the input only depend on the current frame (e.g. collective variables,
+functions, static restraints and \ref PRINT), xyz and gro trajectories can also be analyzed with the
+`--frame-parallel` flag:
+\verbatim
+PLUMED_NUM_THREADS=4 plumed driver --plumed plumed.dat --ixyz trajectory.xyz --frame-parallel
+\endverbatim
+The trajectory is then split in contiguous blocks of frames, one for each thread and MPI process,
+that are analyzed by independent PLUMED instances. At the end, the output files are merged in frame order.
+Inputs containing actions that accumulate information over time (e.g. \ref METAD or averages) are refused,
+as well as collective variables with neighbor lists updated with a stride (e.g. \ref COORDINATION with NLIST),
+which would be rebuilt at the first frame of each block.
+The log of the first block is written as usual, those of the other blocks on the files plumed.log.frames<n>.
+
 PLUMED can read natively xyz files (in PLUMED units) and gro files (in nm). In addition,
 PLUMED includes by default support for a
 subset of the trajectory file formats supported by VMD, e.g. xtc and dcd:
@@ -195,6 +222,219 @@ static int register_cb(void *v, vmdplugin_t *p) {
 }
 #endif
 
+/// Reads a text trajectory in large blocks and splits it in lines.
+/// All the lines of a frame are kept in memory at the same time, so that
+/// they can be parsed in parallel.
+class LineReader {
+  FILE* fp;
+  std::vector<char> buffer;
+/// Position in the file of the first byte in the buffer
+  long offset;
+/// The data in [start,end) has been read but not yet returned
+  size_t start, end;
+  bool eof;
+/// Read more data from the file. Returns false at the end of the file
+  bool fill();
+public:
+  explicit LineReader(FILE*fp): fp(fp), buffer(1<<20), offset(std::ftell(fp)), start(0), end(0), eof(false) {}
+/// Position in the file of the next line that will be returned
+  long tell()const {return offset+start;}
+/// Get the next n lines. The pointers are valid until the next call
+  bool getlines(unsigned n,std::vector<char*> & lines);
+/// Get the next line
+  bool getline(std::string & line);
+};
+
+inline bool LineReader::fill() {
+  if(eof) return false;
+  if(start>0) {
+    std::memmove(buffer.data(),buffer.data()+start,end-start);
+    offset+=start;
+    end-=start; start=0;
+  }
+  if(end==buffer.size()) buffer.resize(2*buffer.size());
+  size_t n=std::fread(buffer.data()+end,1,buffer.size()-end,fp);
+  if(n==0) { eof=true; return false; }
+  end+=n;
+  return true;
+}
+
+inline bool LineReader::getlines(unsigned n,std::vector<char*> & lines) {
+// offsets with respect to start of the first character and of the newline of each line
+  std::vector<std::pair<size_t,size_t> > offsets; offsets.reserve(n);
+  size_t pos=start;
+  while(offsets.size()<n) {
+    char* nl=static_cast<char*>(std::memchr(buffer.data()+pos,'\n',end-pos));
+    if(nl) {
+      size_t e=nl-buffer.data();
+      offsets.push_back(std::make_pair(pos-start,e-start));
+      pos=e+1;
+    } else {
+      size_t done=pos-start;
+      bool more=fill();
+      pos=start+done;
+      if(more) continue;
+// the last line of the file might not be terminated
+      if(pos==end) return false;
+      if(end==buffer.size()) buffer.push_back('\0');
+      offsets.push_back(std::make_pair(pos-start,end-start));
+      pos=end;
+    }
+  }
+  lines.resize(n);
+  for(unsigned i=0; i<n; i++) {
+    char* b=buffer.data()+start+offsets[i].first;
+    char* e=buffer.data()+start+offsets[i].second;
+    *e='\0';
+    if(e>b && *(e-1)=='\r') *(e-1)='\0';
+    lines[i]=b;
+  }
+  start=pos;
+  return true;
+}
+
+inline bool LineReader::getline(std::string & line) {
+  std::vector<char*> l;
+  if(!getlines(1,l)) return false;
+  line=l[0];
+  return true;
+}
+
+/// Reads the frames of an xyz or gro file in a separate thread, so that reading and
+/// parsing the next frames overlaps with the analysis of the current one.
+/// The frames are stored in a small ring of buffers that are reused.
+template<typename real>
+class FrameQueue {
+public:
+  struct Frame {
+    int natoms;
+    std::vector<real> coordinates;
+    std::vector<real> cell;
+  };
+/// Reads the next frame in its argument. Returns false at the end of the file
+  typedef std::function<bool(Frame&)> Parser;
+private:
+  enum {capacity=3};
+  Parser parse;
+  Frame frames[capacity];
+/// frames[head] is the oldest frame, count is the number of frames read
+  unsigned head, count;
+/// frames[head] is being used by the consumer
+  bool held;
+/// The producer has finished (end of file or error)
+  bool done;
+/// The consumer asked the producer to stop
+  bool stop;
+/// Error raised while reading, rethrown by next()
+  std::exception_ptr failure;
+  std::mutex mtx;
+  std::condition_variable cond;
+  std::thread producer;
+/// Loop executed by producer
+  void run();
+public:
+  explicit FrameQueue(const Parser& parse);
+/// Stops and joins the producer
+  ~FrameQueue();
+/// Get the next frame, or NULL at the end of the file.
+/// The frame can be used until the next call. Errors found while reading are rethrown here
+  Frame* next();
+};
+
+template<typename real>
+FrameQueue<real>::FrameQueue(const Parser& parse):
+  parse(parse), head(0), count(0), held(false), done(false), stop(false)
+{
+  producer=std::thread(&FrameQueue::run,this);
+}
+
+template<typename real>
+FrameQueue<real>::~FrameQueue() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop=true;
+  }
+  cond.notify_all();
+  if(producer.joinable()) producer.join();
+}
+
+template<typename real>
+void FrameQueue<real>::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while(true) {
+    cond.wait(lock,[this] {return stop || count<capacity;});
+    if(stop) return;
+// this slot is not used by the consumer, since frames[head] is counted in count
+    Frame & f(frames[(head+count)%capacity]);
+    lock.unlock();
+    bool ok=false;
+    std::exception_ptr e;
+    try {
+      ok=parse(f);
+    } catch(...) {
+      e=std::current_exception();
+    }
+    lock.lock();
+    if(ok) count++;
+    else {
+      failure=e;
+      done=true;
+    }
+    cond.notify_all();
+    if(done) return;
+  }
+}
+
+template<typename real>
+typename FrameQueue<real>::Frame* FrameQueue<real>::next() {
+  std::unique_lock<std::mutex> lock(mtx);
+  if(held) {
+    head=(head+1)%capacity;
+    count--;
+    held=false;
+    cond.notify_all();
+  }
+  cond.wait(lock,[this] {return count>0 || done;});
+  if(count>0) {
+    held=true;
+    return &frames[head];
+  }
+  lock.unlock();
+  if(producer.joinable()) producer.join();
+  if(failure) std::rethrow_exception(failure);
+  return NULL;
+}
+
+/// Parse a line of an xyz file (name x y z)
+static bool parseXyzLine(const char* line,double* cc) {
+  const char* p=line;
+  while(*p && std::isspace(static_cast<unsigned char>(*p))) p++;
+  if(!*p) return false;
+  while(*p && !std::isspace(static_cast<unsigned char>(*p))) p++;
+  for(unsigned k=0; k<3; k++) {
+    char* e;
+    cc[k]=std::strtod(p,&e);
+    if(e==p) return false;
+    p=e;
+  }
+  return true;
+}
+
+/// Parse a line of a gro file, where the coordinates are in fields of width ddist starting at column 20
+static bool parseGroLine(const char* line,int ddist,double* cc) {
+  const size_t len=std::strlen(line);
+  for(unsigned k=0; k<3; k++) {
+    const size_t b=20+k*ddist;
+    if(b>len) return false;
+    std::string field(line+b,std::min(size_t(ddist),len-b));
+    char* e;
+    cc[k]=std::strtod(field.c_str(),&e);
+    while(*e && std::isspace(static_cast<unsigned char>(*e))) e++;
+    if(e==field.c_str() || *e) if(!Tools::convert(field,cc[k])) return false;
+  }
+  return true;
+}
+
 template<typename real>
 class Driver : public CLTool {
 public:
@@ -204,6 +444,16 @@ public:
   void evaluateNumericalDerivatives( const long int& step, PlumedMain& p, const std::vector<real>& coordinates,
                                      const std::vector<real>& masses, const std::vector<real>& charges,
                                      std::vector<real>& cell, const double& base, std::vector<real>& numder );
+/// Set masses and charges from the pdb and mc files
+  void readMassesAndCharges( int natoms, const PDB& pdb, const std::string& mcfile, std::vector<real>& masses, std::vector<real>& charges );
+/// Read box and coordinates of a frame of an xyz or gro file, after the line with the number of atoms.
+/// Only the coordinates of the atoms in [first,first+nlocal) are stored
+  void readTextFrame( LineReader& reader, const std::string& fmt, int natoms, bool pbc_cli_given, const std::vector<double>& pbc_cli_box,
+                      std::vector<char*>& atomlines, std::vector<real>& coordinates, std::vector<real>& cell, int first, int nlocal );
+/// Analyze contiguous blocks of frames with independent PlumedMain objects and merge their output files
+  int runFrameParallel( FILE* out, Communicator& pc, const std::string& plumedFile, const Units& units, real timestep, unsigned stride,
+                        long int step0, real kt, const std::string& trajectoryFile, const std::string& fmt,
+                        bool pbc_cli_given, const std::vector<double>& pbc_cli_box, const PDB& pdb, const std::string& mcfile );
   string description()const;
 };
 
@@ -241,6 +491,8 @@ void Driver<real>::registerKeywords( Keywords& keys ) {
   keys.add("optional","--initial-step","provides a number for the initial step, default is 0");
   keys.add("optional","--debug-forces","output a file containing the forces due to the bias evaluated using numerical derivatives "
            "and using the analytical derivatives implemented in plumed");
+  keys.addFlag("--frame-parallel",false,"analyze contiguous blocks of frames with independent PLUMED instances, one for each thread and MPI process. "
+               "Only works with xyz and gro files and with actions that only depend on the current frame");
   keys.add("hidden","--debug-float","[yes/no] turns on the single precision version (to check float interface)");
   keys.add("hidden","--debug-dd","[yes/no] use a fake domain decomposition");
   keys.add("hidden","--debug-pd","[yes/no] use a fake particle decomposition");
@@ -493,6 +745,19 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     if( !Communicator::initialized() ) error("needs mpi for debug-pd");
   }
 
+  bool frame_parallel=false;
+  parseFlag("--frame-parallel",frame_parallel);
+  if(frame_parallel) {
+    if(trajectory_fmt!="xyz" && trajectory_fmt!="gro") error("--frame-parallel only works with xyz and gro files");
+    if(trajectoryFile=="-") error("--frame-parallel cannot read the trajectory from standard input");
+    if(multi || debug_grex || debug_pd || debug_dd) error("--frame-parallel cannot be used with --multi or with the debug options");
+    if(dumpforces.length()>0 || debugforces.length()>0) error("--frame-parallel cannot be used with --dump-forces or --debug-forces");
+    long int step0=0;
+    parse("--initial-step",step0);
+    return runFrameParallel(out,pc,plumedFile,units,timestep,stride,step0,kt,trajectoryFile,trajectory_fmt,
+                            pbc_cli_given,pbc_cli_box,pdb,mcfile);
+  }
+
   PlumedMain p;
   int rr=sizeof(real);
   p.cmd("setRealPrecision",&rr);
@@ -519,6 +784,11 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   int natoms;
 
   FILE* fp=NULL; FILE* fp_forces=NULL; OFile fp_dforces;
+  std::unique_ptr<LineReader> reader;
+  std::vector<char*> atomlines;
+// declared after reader, so that its thread is stopped before reader is destroyed
+  std::unique_ptr<FrameQueue<real> > frames;
+  typename FrameQueue<real>::Frame* frame=NULL;
 #ifdef __PLUMED_HAS_XDRFILE
   XDRFILE* xd=NULL;
 #endif
@@ -563,6 +833,20 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
         }
       }
     }
+    if(fp) reader.reset(new LineReader(fp));
+    if(fp && use_molfile==false && (trajectory_fmt=="xyz" || trajectory_fmt=="gro")) {
+// all the atoms are read, the coordinates of the non local ones are cleared later with --debug-pd
+      frames.reset(new FrameQueue<real>([&](typename FrameQueue<real>::Frame & f) {
+        std::string l;
+        if(!reader->getline(l)) return false;
+        if(trajectory_fmt=="gro") if(!reader->getline(l)) error("premature end of trajectory file");
+        sscanf(l.c_str(),"%100d",&f.natoms);
+        f.coordinates.assign(3*f.natoms,real(0.0));
+        f.cell.assign(9,real(0.0));
+        readTextFrame(*reader,trajectory_fmt,f.natoms,pbc_cli_given,pbc_cli_box,atomlines,f.coordinates,f.cell,0,f.natoms);
+        return true;
+      }));
+    }
     if(dumpforces.length()>0) {
       if(Communicator::initialized() && pc.Get_size()>1) {
         string n;
@@ -581,7 +865,6 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     }
   }
 
-  std::string line;
   std::vector<real> coordinates;
   std::vector<real> forces;
   std::vector<real> masses;
@@ -619,42 +902,22 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
         }
 #endif
       } else if(trajectory_fmt=="xyz" || trajectory_fmt=="gro") {
-        if(!Tools::getline(fp,line)) break;
+        frame=frames->next();
+        if(!frame) break;
       }
     }
 
     bool first_step=false;
     if(!noatoms) {
       if(use_molfile==false && (trajectory_fmt=="xyz" || trajectory_fmt=="gro")) {
-        if(trajectory_fmt=="gro") if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-        sscanf(line.c_str(),"%100d",&natoms);
+        natoms=frame->natoms;
       }
     }
     if(checknatoms<0 && !noatoms) {
       pd_nlocal=natoms;
       pd_start=0;
       first_step=true;
-      masses.assign(natoms,std::numeric_limits<real>::quiet_NaN());
-      charges.assign(natoms,std::numeric_limits<real>::quiet_NaN());
-//case pdb: structure
-      if(pdbfile.length()>0) {
-        for(unsigned i=0; i<pdb.size(); ++i) {
-          AtomNumber an=pdb.getAtomNumbers()[i];
-          unsigned index=an.index();
-          if( index>=unsigned(natoms) ) error("atom index in pdb exceeds the number of atoms in trajectory");
-          masses[index]=pdb.getOccupancy()[i];
-          charges[index]=pdb.getBeta()[i];
-        }
-      }
-      if(mcfile.length()>0) {
-        IFile ifile;
-        ifile.open(mcfile);
-        int index; double mass; double charge;
-        while(ifile.scanField("index",index).scanField("mass",mass).scanField("charge",charge).scanField()) {
-          masses[index]=mass;
-          charges[index]=charge;
-        }
-      }
+      readMassesAndCharges(natoms,pdb,mcfile,masses,charges);
     } else if( checknatoms<0 && noatoms ) {
       natoms=0;
     }
@@ -783,77 +1046,13 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
             coordinates[3*i+j]=real(pos[i][j]);
 #endif
       } else {
-        if(trajectory_fmt=="xyz") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-
-          std::vector<double> celld(9,0.0);
-          if(pbc_cli_given==false) {
-            std::vector<std::string> words;
-            words=Tools::getWords(line);
-            if(words.size()==3) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
-            } else if(words.size()==9) {
-              sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
-                     &celld[0], &celld[1], &celld[2],
-                     &celld[3], &celld[4], &celld[5],
-                     &celld[6], &celld[7], &celld[8]);
-            } else error("needed box in second line of xyz file");
-          } else {			// from command line
-            celld=pbc_cli_box;
-          }
-          for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
-        }
-        int ddist=0;
-        // Read coordinates
-        for(int i=0; i<natoms; i++) {
-          bool ok=Tools::getline(fp,line);
-          if(!ok) error("premature end of trajectory file");
-          double cc[3];
-          if(trajectory_fmt=="xyz") {
-            char dummy[1000];
-            int ret=std::sscanf(line.c_str(),"%999s %100lf %100lf %100lf",dummy,&cc[0],&cc[1],&cc[2]);
-            if(ret!=4) error("cannot read line"+line);
-          } else if(trajectory_fmt=="gro") {
-            // do the gromacs way
-            if(!i) {
-              //
-              // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
-              //
-              const char      *p1, *p2, *p3;
-              p1 = strchr(line.c_str(), '.');
-              if (p1 == NULL) error("seems there are no coordinates in the gro file");
-              p2 = strchr(&p1[1], '.');
-              if (p2 == NULL) error("seems there is only one coordinates in the gro file");
-              ddist = p2 - p1;
-              p3 = strchr(&p2[1], '.');
-              if (p3 == NULL)error("seems there are only two coordinates in the gro file");
-              if (p3 - p2 != ddist)error("not uniform spacing in fields in the gro file");
-            }
-            Tools::convert(line.substr(20,ddist),cc[0]);
-            Tools::convert(line.substr(20+ddist,ddist),cc[1]);
-            Tools::convert(line.substr(20+ddist+ddist,ddist),cc[2]);
-          } else plumed_error();
-          if(!debug_pd || ( i>=pd_start && i<pd_start+pd_nlocal) ) {
-            coordinates[3*i]=real(cc[0]);
-            coordinates[3*i+1]=real(cc[1]);
-            coordinates[3*i+2]=real(cc[2]);
-          }
+// the buffers are swapped, so that those of the previous frame are reused by the reader
+        coordinates.swap(frame->coordinates);
+        cell.swap(frame->cell);
+        if(debug_pd) {
+          std::fill(coordinates.begin(),coordinates.begin()+3*pd_start,real(0.0));
+          std::fill(coordinates.begin()+3*(pd_start+pd_nlocal),coordinates.end(),real(0.0));
         }
-        if(trajectory_fmt=="gro") {
-          if(!Tools::getline(fp,line)) error("premature end of trajectory file");
-          std::vector<string> words=Tools::getWords(line);
-          if(words.size()<3) error("cannot understand box format");
-          Tools::convert(words[0],cell[0]);
-          Tools::convert(words[1],cell[4]);
-          Tools::convert(words[2],cell[8]);
-          if(words.size()>3) Tools::convert(words[3],cell[1]);
-          if(words.size()>4) Tools::convert(words[4],cell[2]);
-          if(words.size()>5) Tools::convert(words[5],cell[3]);
-          if(words.size()>6) Tools::convert(words[6],cell[5]);
-          if(words.size()>7) Tools::convert(words[7],cell[6]);
-          if(words.size()>8) Tools::convert(words[8],cell[7]);
-        }
-
       }
 
       p.cmd("setStepLong",&step);
@@ -968,6 +1167,7 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
   if(fp_forces) fclose(fp_forces);
   if(debugforces.length()>0) fp_dforces.close();
+  frames.reset();
   if(fp && fp!=in)fclose(fp);
 #ifdef __PLUMED_HAS_XDRFILE
   if(xd) xdrfile_close(xd);
@@ -1038,5 +1238,289 @@ void Driver<real>::evaluateNumericalDerivatives( const long int& step, PlumedMai
 
 }
 
+template<typename real>
+void Driver<real>::readMassesAndCharges( int natoms, const PDB& pdb, const std::string& mcfile, std::vector<real>& masses, std::vector<real>& charges ) {
+  masses.assign(natoms,std::numeric_limits<real>::quiet_NaN());
+  charges.assign(natoms,std::numeric_limits<real>::quiet_NaN());
+//case pdb: structure
+  for(unsigned i=0; i<pdb.size(); ++i) {
+    AtomNumber an=pdb.getAtomNumbers()[i];
+    unsigned index=an.index();
+    if( index>=unsigned(natoms) ) error("atom index in pdb exceeds the number of atoms in trajectory");
+    masses[index]=pdb.getOccupancy()[i];
+    charges[index]=pdb.getBeta()[i];
+  }
+  if(mcfile.length()>0) {
+    IFile ifile;
+    ifile.open(mcfile);
+    int index; double mass; double charge;
+    while(ifile.scanField("index",index).scanField("mass",mass).scanField("charge",charge).scanField()) {
+      masses[index]=mass;
+      charges[index]=charge;
+    }
+  }
+}
+
+template<typename real>
+void Driver<real>::readTextFrame( LineReader& reader, const std::string& fmt, int natoms, bool pbc_cli_given, const std::vector<double>& pbc_cli_box,
+                                  std::vector<char*>& atomlines, std::vector<real>& coordinates, std::vector<real>& cell, int first, int nlocal ) {
+  std::string line;
+  if(fmt=="xyz") {
+    if(!reader.getline(line)) error("premature end of trajectory file");
+
+    std::vector<double> celld(9,0.0);
+    if(pbc_cli_given==false) {
+      std::vector<std::string> words;
+      words=Tools::getWords(line);
+      if(words.size()==3) {
+        sscanf(line.c_str(),"%100lf %100lf %100lf",&celld[0],&celld[4],&celld[8]);
+      } else if(words.size()==9) {
+        sscanf(line.c_str(),"%100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf %100lf",
+               &celld[0], &celld[1], &celld[2],
+               &celld[3], &celld[4], &celld[5],
+               &celld[6], &celld[7], &celld[8]);
+      } else error("needed box in second line of xyz file");
+    } else {			// from command line
+      celld=pbc_cli_box;
+    }
+    for(unsigned i=0; i<9; i++)cell[i]=real(celld[i]);
+  }
+  int ddist=0;
+  // Read coordinates
+  if(!reader.getlines(natoms,atomlines)) error("premature end of trajectory file");
+  const bool xyz=(fmt=="xyz");
+  if(!xyz && natoms>0) {
+    // do the gromacs way
+    //
+    // calculate the distance between dots (as in gromacs gmxlib/confio.c, routine get_w_conf )
+    //
+    const char      *p1, *p2, *p3;
+    p1 = strchr(atomlines[0], '.');
+    if (p1 == NULL) error("seems there are no coordinates in the gro file");
+    p2 = strchr(&p1[1], '.');
+    if (p2 == NULL) error("seems there is only one coordinates in the gro file");
+    ddist = p2 - p1;
+    p3 = strchr(&p2[1], '.');
+    if (p3 == NULL)error("seems there are only two coordinates in the gro file");
+    if (p3 - p2 != ddist)error("not uniform spacing in fields in the gro file");
+  }
+  // Parse the lines in parallel
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*100>unsigned(natoms)) nt=1;
+  int badline=-1;
+  #pragma omp parallel for num_threads(nt)
+  for(int i=0; i<natoms; i++) {
+    double cc[3];
+    bool ok=(xyz ? parseXyzLine(atomlines[i],cc) : parseGroLine(atomlines[i],ddist,cc));
+    if(!ok) {
+      #pragma omp critical
+      if(badline<0 || i<badline) badline=i;
+      continue;
+    }
+    if( i>=first && i<first+nlocal ) {
+      coordinates[3*i]=real(cc[0]);
+      coordinates[3*i+1]=real(cc[1]);
+      coordinates[3*i+2]=real(cc[2]);
+    }
+  }
+  if(badline>=0) error("cannot read line"+std::string(atomlines[badline]));
+  if(fmt=="gro") {
+    if(!reader.getline(line)) error("premature end of trajectory file");
+    std::vector<string> words=Tools::getWords(line);
+    if(words.size()<3) error("cannot understand box format");
+    Tools::convert(words[0],cell[0]);
+    Tools::convert(words[1],cell[4]);
+    Tools::convert(words[2],cell[8]);
+    if(words.size()>3) Tools::convert(words[3],cell[1]);
+    if(words.size()>4) Tools::convert(words[4],cell[2]);
+    if(words.size()>5) Tools::convert(words[5],cell[3]);
+    if(words.size()>6) Tools::convert(words[6],cell[5]);
+    if(words.size()>7) Tools::convert(words[7],cell[6]);
+    if(words.size()>8) Tools::convert(words[8],cell[7]);
+  }
+}
+
+template<typename real>
+int Driver<real>::runFrameParallel( FILE* out, Communicator& pc, const std::string& plumedFile, const Units& units, real timestep, unsigned stride,
+                                    long int step0, real kt, const std::string& trajectoryFile, const std::string& fmt,
+                                    bool pbc_cli_given, const std::vector<double>& pbc_cli_box, const PDB& pdb, const std::string& mcfile ) {
+// Find where each frame starts in the file
+  std::vector<long> offsets;
+  int natoms=-1;
+  {
+    FILE* fp=fopen(trajectoryFile.c_str(),"r");
+    if(!fp) {
+      string msg="ERROR: Error opening trajectory file "+trajectoryFile;
+      fprintf(stderr,"%s\n",msg.c_str());
+      return 1;
+    }
+    LineReader reader(fp);
+    std::string line;
+    std::vector<char*> lines;
+    while(true) {
+      long pos=reader.tell();
+      if(!reader.getline(line)) break;
+      if(fmt=="gro") if(!reader.getline(line)) error("premature end of trajectory file");
+      int n=-1;
+      sscanf(line.c_str(),"%100d",&n);
+      if(natoms<0) natoms=n;
+      if(n!=natoms) {
+        std::string framestr; Tools::convert(offsets.size(),framestr);
+        error("number of atoms in frame " + framestr + " does not match number of atoms in first frame");
+      }
+      if(!reader.getlines(natoms+1,lines)) error("premature end of trajectory file");
+      offsets.push_back(pos);
+    }
+    fclose(fp);
+  }
+  if(natoms<0) natoms=0;
+  std::vector<real> masses, charges;
+  readMassesAndCharges(natoms,pdb,mcfile,masses,charges);
+
+  const unsigned nt=OpenMP::getNumThreads();
+  const unsigned nranks=pc.Get_size();
+  const unsigned rank=pc.Get_rank();
+  const unsigned nworkers=nt*nranks;
+  const unsigned nframes=offsets.size();
+// there should not be empty blocks, otherwise worker 0 might not write the headers of its files
+  const unsigned nblocks=std::max(1u,std::min(nworkers,nframes));
+  fprintf(out,"DRIVER: Analyzing %u frames in %u independent blocks\n",nframes,nblocks);
+  fflush(out);
+
+// Worker w analyzes frames [w*nframes/nblocks,(w+1)*nframes/nblocks)
+// and writes its files with suffix ".frames<w>". Worker 0 has no suffix and writes the usual log,
+// the other workers write their log on plumed.log.frames<w>.
+  auto suffix=[](unsigned w) {
+    std::string s; Tools::convert(w,s);
+    return ".frames"+s;
+  };
+  if(nblocks>1) {
+    fprintf(out,"DRIVER: The logs of the other blocks are written on plumed.log.frames<n>\n");
+    fflush(out);
+  }
+  std::vector<std::string> outputFiles;
+  std::vector<std::exception_ptr> failures(nt);
+
+// The PlumedMain objects of the workers share no data, except for the action and metric registers,
+// which are filled when the library is loaded and only read afterwards, and the OpenMP settings.
+// These are initialized here, and the actions are run with one thread since the threads are
+// already used for the blocks.
+  OpenMP::getCachelineSize();
+  OpenMP::setNumThreads(1);
+
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned w=rank*nt+OpenMP::getThreadNum();
+    const unsigned first=(w<nblocks ? (unsigned long)w*nframes/nblocks : nframes);
+    const unsigned last=(w<nblocks ? (unsigned long)(w+1)*nframes/nblocks : nframes);
+    FILE* fp=NULL;
+    try {
+      if(first<last || w==0) {
+        PlumedMain p;
+        int rr=sizeof(real);
+        p.cmd("setRealPrecision",&rr);
+        p.cmd("setMDLengthUnits",&units.getLength());
+        p.cmd("setMDChargeUnits",&units.getCharge());
+        p.cmd("setMDMassUnits",&units.getMass());
+        p.cmd("setMDEngine","driver");
+        p.cmd("setTimestep",&timestep);
+        p.cmd("setPlumedDat",plumedFile.c_str());
+        if(w==0) p.cmd("setLog",out);
+        else {
+          const std::string logfile="plumed.log"+suffix(w);
+          p.cmd("setLogFile",logfile.c_str());
+          p.setSuffix(suffix(w));
+        }
+        real mykt=kt;
+        if(mykt>=0) p.cmd("setKbT",&mykt);
+        int mynatoms=natoms;
+        p.cmd("setNatoms",&mynatoms);
+        p.cmd("init");
+        for(const auto & a : p.getActionSet()) {
+          if(!a->checkIsStateless()) plumed_merror("action "+a->getLabel()+" depends on the previous frames and cannot be used with --frame-parallel");
+        }
+
+        std::vector<real> mymasses(masses), mycharges(charges);
+        std::vector<real> coordinates(3*natoms), forces(3*natoms), cell(9), virial(9);
+        std::vector<char*> atomlines;
+        std::string line;
+        std::unique_ptr<LineReader> reader;
+        if(first<last) {
+          fp=fopen(trajectoryFile.c_str(),"r");
+          if(!fp) plumed_merror("cannot open trajectory file "+trajectoryFile);
+          if(std::fseek(fp,offsets[first],SEEK_SET)!=0) plumed_merror("cannot seek in trajectory file "+trajectoryFile);
+          reader.reset(new LineReader(fp));
+        }
+        for(unsigned f=first; f<last; f++) {
+          reader->getline(line);
+          if(fmt=="gro") reader->getline(line);
+          coordinates.assign(3*natoms,real(0.0));
+          forces.assign(3*natoms,real(0.0));
+          cell.assign(9,real(0.0));
+          virial.assign(9,real(0.0));
+          readTextFrame(*reader,fmt,natoms,pbc_cli_given,pbc_cli_box,atomlines,coordinates,cell,0,natoms);
+          long int step=step0+(long int)f*stride;
+          int plumedStopCondition=0;
+          p.cmd("setStepLong",&step);
+          p.cmd("setStopFlag",&plumedStopCondition);
+          if(natoms>0) {
+            p.cmd("setForces",&forces[0]);
+            p.cmd("setPositions",&coordinates[0]);
+            p.cmd("setMasses",&mymasses[0]);
+            p.cmd("setCharges",&mycharges[0]);
+          }
+          p.cmd("setBox",&cell[0]);
+          p.cmd("setVirial",&virial[0]);
+          p.cmd("calc");
+          if(plumedStopCondition) break;
+        }
+        p.cmd("runFinalJobs");
+        if(w==0) outputFiles=p.getOutputFiles();
+      }
+    } catch(...) {
+      failures[OpenMP::getThreadNum()]=std::current_exception();
+    }
+    if(fp) fclose(fp);
+  }
+  OpenMP::setNumThreads(nt);
+
+  int failed=0;
+  for(const auto & f : failures) if(f) failed=1;
+  pc.Sum(failed);
+  for(const auto & f : failures) if(f) std::rethrow_exception(f);
+  if(failed) error("--frame-parallel failed on another process");
+  pc.Barrier();
+
+// Append the files of the other workers to those of worker 0, in frame order
+  if(rank==0) {
+    for(const auto & path : outputFiles) {
+      if(path=="/dev/null") continue;
+      const std::string ext=Tools::extension(path);
+      const bool binary=(ext=="gz" || ext=="xtc" || ext=="trr");
+      FILE* fout=fopen(path.c_str(),"a");
+      if(!fout) error("cannot append to file "+path);
+      for(unsigned w=1; w<nblocks; w++) {
+        const std::string name=FileBase::appendSuffix(path,suffix(w));
+        FILE* fin=fopen(name.c_str(),"r");
+        if(!fin) continue;
+        if(binary) {
+          std::vector<char> buffer(1<<20);
+          size_t n;
+          while((n=std::fread(buffer.data(),1,buffer.size(),fin))>0) std::fwrite(buffer.data(),1,n,fout);
+        } else {
+// the header lines are already in the file of worker 0
+          LineReader reader(fin);
+          std::string line;
+          while(reader.getline(line)) if(line.compare(0,2,"#!")!=0) fprintf(fout,"%s\n",line.c_str());
+        }
+        fclose(fin);
+        std::remove(name.c_str());
+      }
+      fclose(fout);
+    }
+  }
+  return 0;
+}
+
 }
 }
@@ -31,7 +31,9 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include <memory>
 #include "tools/File.h"
+#include "tools/BinaryHills.h"
 #include "core/Value.h"
 #include "tools/Matrix.h"
 
@@ -98,6 +100,9 @@ You can use a --stride keyword to have a dump each bunch of hills you read
 plumed sum_hills --stride 300 --hills PATHTOMYHILLSFILE
 \endverbatim
 
+Hills files written in binary format (see the BINARY_HILLS keyword of \ref METAD) are recognized automatically
+and are read much faster than text files.
+
 You can also have, in case of welltempered metadynamics, only the negative
 bias instead of the free energy through the keyword --negbias
 
@@ -541,7 +546,16 @@ bool CLToolSumHills::findCvsAndPeriodic(std::string filename, std::vector< std::
   if(ifile.FileExist(filename)) {
     cvs.clear(); pmin.clear(); pmax.clear();
     ifile.open(filename);
-    ifile.scanFieldList(fields);
+    std::unique_ptr<BinaryHillsReader> reader;
+    if(BinaryHillsReader::isBinary(ifile.getPath())) {
+      reader.reset(new BinaryHillsReader(ifile));
+      if(!reader->readHeader()) return false;
+      fields=reader->getFields();
+      for(const auto & c : reader->getConstants()) fields.push_back(c.first);
+    } else ifile.scanFieldList(fields);
+    // access to the constant fields of the header
+    auto fieldExist=[&](const std::string & name) { return (reader ? reader->constantExist(name) : ifile.FieldExist(name)); };
+    auto scanField=[&](const std::string & name,std::string & val) { if(reader) val=reader->getConstant(name); else ifile.scanField(name,val); };
     bool before_sigma=true;
     for(unsigned i=0; i<fields.size(); i++) {
       size_t pos = 0;
@@ -578,16 +592,16 @@ bool CLToolSumHills::findCvsAndPeriodic(std::string filename, std::vector< std::
         pmin.push_back("none");
         pmax.push_back("none");
         std::string mm; if((cvs.back()).size()>1) {mm=cvs.back()[0]+"."+cvs.back()[1];} else {mm=cvs.back()[0];}
-        if(ifile.FieldExist("min_"+mm)) {
+        if(fieldExist("min_"+mm)) {
           std::string val;
-          ifile.scanField("min_"+mm,val);
+          scanField("min_"+mm,val);
           pmin[pmin.size()-1]=val;
           // std::cerr<<"found min   :  "<<pmin.back()<<std::endl;
         }
         //std::cerr<<"found min   :  "<<pmin.back()<<std::endl;
-        if(ifile.FieldExist("max_"+mm)) {
+        if(fieldExist("max_"+mm)) {
           std::string val;
-          ifile.scanField("max_"+mm,val);
+          scanField("max_"+mm,val);
           pmax[pmax.size()-1]=val;
           // std::cerr<<"found max   :  "<<pmax.back()<<std::endl;
         }
@@ -597,21 +611,21 @@ bool CLToolSumHills::findCvsAndPeriodic(std::string filename, std::vector< std::
     // is multivariate ???
     std::string sss;
     multivariate=false;
-    if(ifile.FieldExist("multivariate")) {
+    if(fieldExist("multivariate")) {
       ;
-      ifile.scanField("multivariate",sss);
+      scanField("multivariate",sss);
       if(sss=="true") { multivariate=true;}
       else if(sss=="false") { multivariate=false;}
     }
     // do interval?
-    if(ifile.FieldExist("lower_int")) {
-      ifile.scanField("lower_int",lowI_);
-      ifile.scanField("upper_int",uppI_);
+    if(fieldExist("lower_int")) {
+      scanField("lower_int",lowI_);
+      scanField("upper_int",uppI_);
     } else {
       lowI_="-1.";
       uppI_="-1.";
     }
-    ifile.scanField();
+    if(!reader) ifile.scanField();
     return true;
   } else {
     return false;
@@ -88,6 +88,7 @@ class Angle : public Colvar {
 
 public:
   explicit Angle(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
   static void registerKeywords( Keywords& keys );
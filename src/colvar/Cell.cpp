@@ -54,6 +54,7 @@ class Cell : public Colvar {
 
 public:
   explicit Cell(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
 /// Register all the keywords for this action
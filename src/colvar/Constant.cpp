@@ -68,6 +68,7 @@ class Constant : public Colvar {
   vector<double> values;
 public:
   explicit Constant(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords( Keywords& keys );
 };
@@ -117,6 +117,7 @@ private:
 public:
   static void registerKeywords( Keywords& keys );
   explicit ContactMap(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
   void checkFieldsAllowed() {}
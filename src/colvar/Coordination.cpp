@@ -104,6 +104,7 @@ public:
 // active methods:
   static void registerKeywords( Keywords& keys );
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const;
+  virtual void pairings(unsigned n,const double*distance,double*result,double*dfunc,const unsigned*i,const unsigned*j)const;
 };
 
 PLUMED_REGISTER_ACTION(Coordination,"COORDINATION")
@@ -153,6 +154,12 @@ double Coordination::pairing(double distance,double&dfunc,unsigned i,unsigned j)
   return switchingFunction.calculateSqr(distance,dfunc);
 }
 
+void Coordination::pairings(unsigned n,const double*distance,double*result,double*dfunc,const unsigned*i,const unsigned*j)const {
+  (void) i; // avoid warnings
+  (void) j; // avoid warnings
+  switchingFunction.calculateSqr(n,distance,result,dfunc);
+}
+
 }
 
 }
@@ -25,6 +25,7 @@
 #include "tools/OpenMP.h"
 
 #include <string>
+#include <algorithm>
 
 using namespace std;
 
@@ -38,6 +39,7 @@ void CoordinationBase::registerKeywords( Keywords& keys ) {
   keys.addFlag("NLIST",false,"Use a neighbour list to speed up the calculation");
   keys.add("optional","NL_CUTOFF","The cutoff for the neighbour list");
   keys.add("optional","NL_STRIDE","The frequency with which we are updating the atoms in the neighbour list");
+  keys.addFlag("NL_LINKCELLS",false,"Use link cells to update the neighbour list. This makes the cost of the update linear in the number of atoms");
   keys.add("atoms","GROUPA","First list of atoms");
   keys.add("atoms","GROUPB","Second list of atoms (if empty, N*(N-1)/2 pairs in GROUPA are counted)");
 }
@@ -68,12 +70,14 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   bool doneigh=false;
   double nl_cut=0.0;
   int nl_st=0;
+  bool nl_cells=false;
   parseFlag("NLIST",doneigh);
   if(doneigh) {
     parse("NL_CUTOFF",nl_cut);
     if(nl_cut<=0.0) error("NL_CUTOFF should be explicitly specified and positive");
     parse("NL_STRIDE",nl_st);
     if(nl_st<=0) error("NL_STRIDE should be explicitly specified and positive");
+    parseFlag("NL_LINKCELLS",nl_cells);
   }
 
   addValueWithDerivatives(); setNotPeriodic();
@@ -84,6 +88,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
     if(doneigh)  nl.reset( new NeighborList(ga_lista,pbc,getPbc(),nl_cut,nl_st) );
     else         nl.reset( new NeighborList(ga_lista,pbc,getPbc()) );
   }
+  if(nl_cells) nl->setUseLinkCells(true);
 
   requestAtoms(nl->getFullAtomList());
 
@@ -105,6 +110,7 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   if(doneigh) {
     log.printf("  using neighbor lists with\n");
     log.printf("  update every %d steps and cutoff %f\n",nl_st,nl_cut);
+    if(nl_cells) log.printf("  neighbor list is updated using link cells\n");
   }
 }
 
@@ -112,6 +118,10 @@ CoordinationBase::~CoordinationBase() {
 // destructor required to delete forward declared class
 }
 
+bool CoordinationBase::checkIsStateless()const {
+  return nl->getStride()==0;
+}
+
 void CoordinationBase::prepare() {
   if(nl->getStride()>0) {
     if(firsttime || (getStep()%nl->getStride()==0)) {
@@ -128,6 +138,10 @@ void CoordinationBase::prepare() {
 }
 
 // calculator
+void CoordinationBase::pairings(unsigned n,const double*distance,double*result,double*dfunc,const unsigned*i,const unsigned*j)const {
+  for(unsigned k=0; k<n; k++) result[k]=pairing(distance[k],dfunc[k],i[k],j[k]);
+}
+
 void CoordinationBase::calculate()
 {
 
@@ -154,47 +168,55 @@ void CoordinationBase::calculate()
   const unsigned nn=nl->size();
   if(nt*stride*10>nn) nt=1;
 
+  if(nt>1) reduction.resize(nt,deriv.size());
+
+// pairs are processed in blocks, so that the pairing function can be evaluated on many distances at once
+  const unsigned block=64;
+  const unsigned npairs=(nn>rank?(nn-rank+stride-1)/stride:0);
+  const unsigned nblocks=(npairs+block-1)/block;
+
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<Vector> omp_deriv(getPositions().size());
-    Tensor omp_virial;
+    std::vector<Vector> & omp_deriv(nt>1?reduction.getBuffer(OpenMP::getThreadNum()):deriv);
+    Tensor & omp_virial(nt>1?reduction.getVirial(OpenMP::getThreadNum()):virial);
+    unsigned i0[block],i1[block];
+    Vector distance[block];
+    double distance2[block],value[block],dfunc[block];
 
     #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
-
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
-
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
-
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
+    for(unsigned ib=0; ib<nblocks; ib++) {
+
+      unsigned n=0;
+      for(unsigned k=ib*block; k<std::min(npairs,(ib+1)*block); k++) {
+        const unsigned i=rank+k*stride;
+        i0[n]=nl->getClosePair(i).first;
+        i1[n]=nl->getClosePair(i).second;
+
+        if(getAbsoluteIndex(i0[n])==getAbsoluteIndex(i1[n])) continue;
+
+        if(pbc) {
+          distance[n]=pbcDistance(getPosition(i0[n]),getPosition(i1[n]));
+        } else {
+          distance[n]=delta(getPosition(i0[n]),getPosition(i1[n]));
+        }
+        distance2[n]=distance[n].modulo2();
+        n++;
       }
 
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
+      pairings(n,distance2,value,dfunc,i0,i1);
 
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
+      for(unsigned j=0; j<n; j++) {
+        ncoord += value[j];
+
+        Vector dd(dfunc[j]*distance[j]);
+        Tensor vv(dd,distance[j]);
+        omp_deriv[i0[j]]-=dd;
+        omp_deriv[i1[j]]+=dd;
         omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
       }
 
     }
-    #pragma omp critical
-    if(nt>1) {
-      for(unsigned i=0; i<getPositions().size(); i++) deriv[i]+=omp_deriv[i];
-      virial+=omp_virial;
-    }
+    if(nt>1) reduction.reduce(deriv,virial);
   }
 
   if(!serial) {
@@ -203,7 +225,9 @@ void CoordinationBase::calculate()
     comm.Sum(virial);
   }
 
-  for(unsigned i=0; i<deriv.size(); ++i) setAtomsDerivatives(i,deriv[i]);
+// with SPARSE_DERIVATIVES the atoms that have no neighbors are not stored
+  const bool sparse=getPntrToValue()->hasSparseDerivatives();
+  for(unsigned i=0; i<deriv.size(); ++i) if(!sparse || modulo2(deriv[i])>0.0) setAtomsDerivatives(i,deriv[i]);
   setValue           (ncoord);
   setBoxDerivatives  (virial);
 
@@ -22,6 +22,7 @@
 #ifndef __PLUMED_colvar_CoordinationBase_h
 #define __PLUMED_colvar_CoordinationBase_h
 #include "Colvar.h"
+#include "tools/ThreadReduction.h"
 #include <memory>
 
 namespace PLMD {
@@ -36,14 +37,21 @@ class CoordinationBase : public Colvar {
   std::unique_ptr<NeighborList> nl;
   bool invalidateList;
   bool firsttime;
+/// Per-thread buffers for derivatives and virial
+  ThreadReduction<Vector> reduction;
 
 public:
   explicit CoordinationBase(const ActionOptions&);
+/// A neighbor list updated with a stride depends on the frame where it was built
+  bool checkIsStateless()const;
   ~CoordinationBase();
 // active methods:
   virtual void calculate();
   virtual void prepare();
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
+/// Compute the pairing function for n pairs at once.
+/// By default it calls pairing() on each pair.
+  virtual void pairings(unsigned n,const double*distance,double*result,double*dfunc,const unsigned*i,const unsigned*j)const;
   static void registerKeywords( Keywords& keys );
 };
 
@@ -107,6 +107,7 @@ class DRMSD : public Colvar {
 
 public:
   explicit DRMSD(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
 };
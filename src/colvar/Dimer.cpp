@@ -136,6 +136,7 @@ class Dimer : public Colvar {
 public:
   static void registerKeywords( Keywords& keys);
   explicit Dimer(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
 protected:
   bool trimer,useall;
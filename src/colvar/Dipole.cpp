@@ -69,6 +69,7 @@ class Dipole : public Colvar {
   bool nopbc;
 public:
   explicit Dipole(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -116,6 +116,7 @@ class Distance : public Colvar {
 public:
   static void registerKeywords( Keywords& keys );
   explicit Distance(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
 };
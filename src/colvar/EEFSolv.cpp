@@ -28,7 +28,12 @@
 #include "core/PlumedMain.h"
 #include "core/SetupMolInfo.h"
 #include "tools/OpenMP.h"
+#include "tools/ThreadReduction.h"
+#include "tools/LinkCells.h"
+#include "tools/Pbc.h"
 #include <initializer_list>
+#include <array>
+#include <algorithm>
 
 #define INV_PI_SQRT_PI 0.179587122
 #define KCAL_TO_KJ 4.184
@@ -84,10 +89,18 @@ private:
   double delta_g_ref;
   unsigned stride;
   unsigned nl_update;
-  vector<vector<unsigned> > nl;
-  vector<vector<bool> > nlexpo;
-  vector<vector<double> > parameter;
-  void setupConstants(const vector<AtomNumber> &atoms, vector<vector<double> > &parameter, bool tcorr);
+/// Neighbour list in CSR format: the neighbours of atom i are nl[nl_start[i]] to nl[nl_start[i+1]-1]
+  vector<unsigned> nl_start;
+  vector<unsigned> nl;
+/// For each pair in nl, tells if the two atoms have the same lambda and radius (a single exponential is needed)
+  vector<unsigned char> nlexpo;
+/// Per-atom parameters (volume, free energy, inverse lambda, radius), stored contiguously
+  vector<array<double,4> > parameter;
+/// Link cells used to rebuild the neighbour list
+  LinkCells linkcells;
+/// Per-thread buffers for the derivatives
+  ThreadReduction<Vector> reduction;
+  void setupConstants(const vector<AtomNumber> &atoms, vector<array<double,4> > &parameter, bool tcorr);
   map<string, map<string, string> > setupTypeMap();
   map<string, vector<double> > setupValueMap();
   void update_neighb();
@@ -116,7 +129,8 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
   buffer(0.1),
   delta_g_ref(0.),
   stride(10),
-  nl_update(0)
+  nl_update(0),
+  linkcells(comm)
 {
   vector<AtomNumber> atoms;
   parseAtomList("ATOMS", atoms);
@@ -135,9 +149,7 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
   log << "  Bibliography " << plumed.cite("Lazaridis T, Karplus M, Proteins Struct. Funct. Genet. 35, 133 (1999)"); log << "\n";
 
 
-  nl.resize(size);
-  nlexpo.resize(size);
-  parameter.resize(size, vector<double>(4, 0));
+  parameter.resize(size, array<double,4>());
   setupConstants(atoms, parameter, tcorr);
 
   addValueWithDerivatives();
@@ -148,29 +160,80 @@ EEFSolv::EEFSolv(const ActionOptions&ao):
 void EEFSolv::update_neighb() {
   const double lower_c2 = 0.24 * 0.24; // this is the cut-off for bonded atoms
   const unsigned size = getNumberOfAtoms();
-  for (unsigned i=0; i<size; ++i) {
-    nl[i].clear();
-    nlexpo[i].clear();
-    const Vector posi = getPosition(i);
-    // Loop through neighboring atoms, add the ones below cutoff
-    for (unsigned j=i+1; j<size; ++j) {
-      const double d2 = delta(posi, getPosition(j)).modulo2();
-      if (d2 < lower_c2 && j < i+14) {
-        // crude approximation for i-i+1/2 interactions,
-        // we want to exclude atoms separated by less than three bonds
-        continue;
-      }
-      // We choose the maximum lambda value and use a more conservative cutoff
-      double mlambda = 1./parameter[i][2];
-      if (1./parameter[j][2] > mlambda) mlambda = 1./parameter[j][2];
-      const double c2 = (4. * mlambda + buffer) * (4. * mlambda + buffer);
-      if (d2 < c2 ) {
-        nl[i].push_back(j);
-        if(parameter[i][2] == parameter[j][2] && parameter[i][3] == parameter[j][3]) {
-          nlexpo[i].push_back(true);
-        } else nlexpo[i].push_back(false);
+  const vector<Vector> & positions(getPositions());
+  // The cells are built with the largest cutoff, the pair specific one is checked below
+  double max_lambda = 0.;
+  for (unsigned i=0; i<size; ++i) max_lambda = std::max(max_lambda, 1./parameter[i][2]);
+  const double max_cutoff = 4. * max_lambda + buffer;
+  // Distances are computed without periodic boundaries, so the cells are built in an orthorhombic box
+  // enclosing all the atoms. Periodic images can then only add candidates, which are discarded below.
+  Vector lower(positions[0]), upper(positions[0]);
+  for (unsigned i=1; i<size; ++i) for (unsigned k=0; k<3; ++k) {
+      lower[k] = std::min(lower[k], positions[i][k]);
+      upper[k] = std::max(upper[k], positions[i][k]);
+    }
+  Tensor box;
+  for (unsigned k=0; k<3; ++k) box(k,k) = upper[k] - lower[k] + max_cutoff;
+  Pbc cellpbc;
+  cellpbc.setBox(box);
+  vector<unsigned> cellind(size);
+  for (unsigned i=0; i<size; ++i) cellind[i] = i;
+  linkcells.setCutoff(max_cutoff);
+  linkcells.buildCellLists(positions, cellind, cellpbc);
+
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*10>size) nt=1;
+  nl_start.assign(size+1, 0);
+  // Each thread stores the neighbours of a contiguous block of atoms, which is then copied in place
+  vector<vector<unsigned> > thread_nl(nt);
+  vector<vector<unsigned char> > thread_expo(nt);
+  vector<unsigned> thread_first(nt, size);
+  #pragma omp parallel num_threads(nt)
+  {
+    const unsigned t = OpenMP::getThreadNum();
+    vector<unsigned> & mynl(thread_nl[t]);
+    vector<unsigned char> & myexpo(thread_expo[t]);
+    vector<unsigned> cell_list, atoms(size+1), close;
+    #pragma omp for schedule(static)
+    for (unsigned i=0; i<size; ++i) {
+      if(thread_first[t] == size) thread_first[t] = i;
+      unsigned natomsper = 1; atoms[0] = i;
+      linkcells.retrieveNeighboringAtoms(positions[i], cell_list, natomsper, atoms);
+      close.clear();
+      // Loop through neighboring atoms, add the ones below cutoff
+      for (unsigned k=1; k<natomsper; ++k) {
+        const unsigned j = atoms[k];
+        if (j < i) continue;
+        const double d2 = delta(positions[i], positions[j]).modulo2();
+        if (d2 < lower_c2 && j < i+14) {
+          // crude approximation for i-i+1/2 interactions,
+          // we want to exclude atoms separated by less than three bonds
+          continue;
+        }
+        // We choose the maximum lambda value and use a more conservative cutoff
+        double mlambda = 1./parameter[i][2];
+        if (1./parameter[j][2] > mlambda) mlambda = 1./parameter[j][2];
+        const double c2 = (4. * mlambda + buffer) * (4. * mlambda + buffer);
+        if (d2 < c2 ) close.push_back(j);
+      }
+      // Neighbours are kept in increasing order, as when looping over all pairs
+      std::sort(close.begin(), close.end());
+      nl_start[i+1] = close.size();
+      for (const auto & j : close) {
+        mynl.push_back(j);
+        myexpo.push_back(parameter[i][2] == parameter[j][2] && parameter[i][3] == parameter[j][3]);
       }
     }
+    #pragma omp single
+    {
+      for (unsigned i=0; i<size; ++i) nl_start[i+1] += nl_start[i];
+      nl.resize(nl_start[size]);
+      nlexpo.resize(nl_start[size]);
+    }
+    if(thread_first[t] < size) {
+      std::copy(mynl.begin(), mynl.end(), nl.begin() + nl_start[thread_first[t]]);
+      std::copy(myexpo.begin(), myexpo.end(), nlexpo.begin() + nl_start[thread_first[t]]);
+    }
   }
 }
 
@@ -185,12 +248,13 @@ void EEFSolv::calculate() {
   double bias = 0.0;
   Tensor deriv_box;
   unsigned nt=OpenMP::getNumThreads();
-  const unsigned nn=nl.size();
-  if(nt*10>nn) nt=1;
+  if(nt*10>size) nt=1;
+  vector<Vector> deriv(size);
+  if(nt>1) reduction.resize(nt,size);
   #pragma omp parallel num_threads(nt)
   {
-    vector<Vector> deriv_omp(size);
-    #pragma omp for reduction(+:bias)
+    vector<Vector> & deriv_omp(nt>1?reduction.getBuffer(OpenMP::getThreadNum()):deriv);
+    #pragma omp for reduction(+:bias) nowait
     for (unsigned i=0; i<size; ++i) {
       const Vector posi = getPosition(i);
       double fedensity = 0.0;
@@ -201,8 +265,8 @@ void EEFSolv::calculate() {
       const double vdw_radius_i   = parameter[i][3];
 
       // The pairwise interactions are unsymmetric, but we can get away with calculating the distance only once
-      for (unsigned i_nl=0; i_nl<nl[i].size(); ++i_nl) {
-        const unsigned j = nl[i][i_nl];
+      for (unsigned i_nl=nl_start[i]; i_nl<nl_start[i+1]; ++i_nl) {
+        const unsigned j = nl[i_nl];
         const double vdw_volume_j   = parameter[j][0];
         const double delta_g_free_j = parameter[j][1];
         const double inv_lambda_j   = parameter[j][2];
@@ -217,7 +281,7 @@ void EEFSolv::calculate() {
         double deriv = 0.;
 
         // in this case we can calculate a single exponential
-        if(!nlexpo[i][i_nl]) {
+        if(!nlexpo[i_nl]) {
           // i-j interaction
           if(inv_rij > 0.25*inv_lambda_i)
           {
@@ -259,11 +323,12 @@ void EEFSolv::calculate() {
       deriv_omp[i] += deriv_i;
       bias += - 0.5 * fedensity;
     }
-    #pragma omp critical
-    for(unsigned i=0; i<size; i++) {
-      setAtomsDerivatives(i, -deriv_omp[i]);
-      deriv_box += Tensor(getPosition(i), -deriv_omp[i]);
-    }
+    if(nt>1) reduction.reduce(deriv);
+  }
+
+  for(unsigned i=0; i<size; i++) {
+    setAtomsDerivatives(i, -deriv[i]);
+    deriv_box += Tensor(getPosition(i), -deriv[i]);
   }
 
   setBoxDerivatives(-deriv_box);
@@ -276,7 +341,7 @@ void EEFSolv::calculate() {
   }
 }
 
-void EEFSolv::setupConstants(const vector<AtomNumber> &atoms, vector<vector<double> > &parameter, bool tcorr) {
+void EEFSolv::setupConstants(const vector<AtomNumber> &atoms, vector<array<double,4> > &parameter, bool tcorr) {
   vector<vector<double> > parameter_temp;
   parameter_temp.resize(atoms.size());
   map<string, vector<double> > valuemap;
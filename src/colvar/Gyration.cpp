@@ -91,6 +91,7 @@ private:
 public:
   static void registerKeywords(Keywords& keys);
   explicit Gyration(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
 };
 
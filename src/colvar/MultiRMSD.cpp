@@ -44,6 +44,7 @@ class MultiRMSD : public Colvar {
 
 public:
   explicit MultiRMSD(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -71,6 +71,7 @@ class Position : public Colvar {
 public:
   static void registerKeywords( Keywords& keys );
   explicit Position(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
 };
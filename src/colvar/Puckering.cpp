@@ -77,6 +77,7 @@ class Puckering : public Colvar {
 
 public:
   explicit Puckering(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
   void calculate5m();
@@ -43,6 +43,7 @@ class RMSD : public Colvar {
 
 public:
   explicit RMSD(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -96,6 +96,7 @@ class Torsion : public Colvar {
 
 public:
   explicit Torsion(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
   static void registerKeywords(Keywords& keys);
@@ -50,6 +50,7 @@ class Volume : public Colvar {
 
 public:
   explicit Volume(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
 /// Register all the keywords for this action
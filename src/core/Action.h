@@ -262,6 +262,11 @@ public:
 /// Check if the action needs gradient
   virtual bool checkNeedsGradients()const {return false;}
 
+/// Check if the action only depends on the current frame.
+/// Actions that keep a history (e.g. adaptive biases or averages) should return false,
+/// so that they are refused when frames are analyzed independently (see driver --frame-parallel)
+  virtual bool checkIsStateless()const {return false;}
+
 /// Perform calculation using numerical derivatives
 /// N.B. only pass an ActionWithValue to this routine if you know exactly what you
 /// are doing.
@@ -32,6 +32,7 @@
 #include "Atoms.h"
 #include "tools/Pbc.h"
 #include "tools/PDB.h"
+#include "tools/Tools.h"
 
 using namespace std;
 
@@ -44,6 +45,7 @@ ActionAtomistic::~ActionAtomistic() {
 
 ActionAtomistic::ActionAtomistic(const ActionOptions&ao):
   Action(ao),
+  sparseForces(false),
   lockRequestAtoms(false),
   donotretrieve(false),
   donotforce(false),
@@ -60,6 +62,9 @@ void ActionAtomistic::registerKeywords( Keywords& keys ) {
 
 void ActionAtomistic::requestAtoms(const vector<AtomNumber> & a) {
   plumed_massert(!lockRequestAtoms,"requested atom list can only be changed in the prepare() method");
+// the list of unique atoms only needs to be rebuilt if the request has changed
+// (e.g. neighbor lists are often requesting the same atoms between updates)
+  const bool changed=(a!=indexes);
   int nat=a.size();
   indexes=a;
   positions.resize(nat);
@@ -68,15 +73,17 @@ void ActionAtomistic::requestAtoms(const vector<AtomNumber> & a) {
   charges.resize(nat);
   int n=atoms.positions.size();
   clearDependencies();
-  unique.clear();
+  if(changed) unique.clear();
   for(unsigned i=0; i<indexes.size(); i++) {
     if(indexes[i].index()>=n) error("atom out of range");
     if(atoms.isVirtualAtom(indexes[i])) addDependency(atoms.getVirtualAtomsAction(indexes[i]));
 // only real atoms are requested to lower level Atoms class
-    else unique.insert(indexes[i]);
+    else if(changed) unique.push_back(indexes[i]);
   }
+  if(!changed) return;
+  Tools::removeDuplicates(unique);
   updateUniqueLocal();
-  atoms.unique.clear();
+  atoms.clearUnique();
 }
 
 Vector ActionAtomistic::pbcDistance(const Vector &v1,const Vector &v2)const {
@@ -259,16 +266,37 @@ void ActionAtomistic::applyForces() {
   if(donotforce) return;
   vector<Vector>   & f(atoms.forces);
   Tensor           & v(atoms.virial);
-  for(unsigned j=0; j<indexes.size(); j++) f[indexes[j].index()]+=forces[j];
+  if(sparseForces) {
+    for(const auto & j : forcedAtoms) f[indexes[j].index()]+=forces[j];
+  } else {
+    for(unsigned j=0; j<indexes.size(); j++) f[indexes[j].index()]+=forces[j];
+  }
   v+=virial;
   atoms.forceOnEnergy+=forceOnEnergy;
   if(extraCV.length()>0) atoms.updateExtraCVForce(extraCV,forceOnExtraCV);
 }
 
+void ActionAtomistic::useSparseForces() {
+  sparseForces=true;
+  if(atomIsForced.size()!=forces.size()) {
+    plumed_dbg_assert(forcedAtoms.empty());
+    atomIsForced.assign(forces.size(),0);
+  }
+}
+
 void ActionAtomistic::clearOutputForces() {
   virial.zero();
   if(donotforce) return;
-  for(unsigned i=0; i<forces.size(); ++i)forces[i].zero();
+  if(sparseForces) {
+    for(const auto & i : forcedAtoms) {
+      if(i<forces.size()) forces[i].zero();
+      atomIsForced[i]=0;
+    }
+    forcedAtoms.clear();
+    sparseForces=false;
+  } else {
+    for(unsigned i=0; i<forces.size(); ++i)forces[i].zero();
+  }
   forceOnEnergy=0.0;
   forceOnExtraCV=0.0;
 }
@@ -296,13 +324,13 @@ void ActionAtomistic::makeWhole() {
 }
 
 void ActionAtomistic::updateUniqueLocal() {
-  unique_local.clear();
   if(atoms.dd && atoms.shuffledAtoms>0) {
-    for(auto pp=unique.begin(); pp!=unique.end(); ++pp) {
-      if(atoms.g2l[pp->index()]>=0) unique_local.insert(*pp);
+    unique_local.clear();
+    for(const auto & p : unique) {
+      if(atoms.g2l[p.index()]>=0) unique_local.push_back(p);
     }
   } else {
-    unique_local.insert(unique.begin(),unique.end());
+    unique_local=unique;
   }
 }
 
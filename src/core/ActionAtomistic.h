@@ -43,10 +43,11 @@ class ActionAtomistic :
 {
 
   std::vector<AtomNumber> indexes;         // the set of needed atoms
-/// unique should be an ordered set since we later create a vector containing the corresponding indexes
-  std::set<AtomNumber>  unique;
-/// unique_local should be an ordered set since we later create a vector containing the corresponding indexes
-  std::set<AtomNumber>  unique_local;
+/// unique is a sorted list without duplicates since we later create a vector containing the corresponding indexes.
+/// It is only rebuilt when the list of requested atoms changes
+  std::vector<AtomNumber>  unique;
+/// unique_local is the sorted list of the atoms in unique that are local
+  std::vector<AtomNumber>  unique_local;
   std::vector<Vector>   positions;       // positions of the needed atoms
   double                energy;
   ForwardDecl<Pbc>      pbc_fwd;
@@ -57,6 +58,9 @@ class ActionAtomistic :
   std::vector<double>   charges;
 
   std::vector<Vector>   forces;          // forces on the needed atoms
+  bool                  sparseForces;    // only the atoms in forcedAtoms have a force
+  std::vector<unsigned> forcedAtoms;     // the atoms with a force (only with sparse forces)
+  std::vector<char>     atomIsForced;    // flags telling which atoms are in forcedAtoms
   double                forceOnEnergy;
 
   double                forceOnExtraCV;
@@ -121,6 +125,11 @@ public:
   double getCharge(int i)const;
 /// Get a reference to forces array
   std::vector<Vector> & modifyForces();
+/// Tell that, until the forces are cleared, only the atoms passed to markForcedAtom()
+/// have a force. This allows to skip the other atoms when applying and clearing the forces
+  void useSparseForces();
+/// Tell that atom i has a force (only needed after useSparseForces())
+  void markForcedAtom(unsigned i);
 /// Get a reference to virial array
   Tensor & modifyVirial();
 /// Get a reference to force on energy
@@ -187,8 +196,8 @@ public:
   void applyForces();
   void lockRequests();
   void unlockRequests();
-  const std::set<AtomNumber> & getUnique()const;
-  const std::set<AtomNumber> & getUniqueLocal()const;
+  const std::vector<AtomNumber> & getUnique()const;
+  const std::vector<AtomNumber> & getUniqueLocal()const;
 /// Read in an input file containing atom positions and calculate the action for the atomic
 /// configuration therin
   void readAtomsFromPDB( const PDB& pdb );
@@ -260,6 +269,15 @@ std::vector<Vector> & ActionAtomistic::modifyForces() {
   return forces;
 }
 
+inline
+void ActionAtomistic::markForcedAtom(unsigned i) {
+  plumed_dbg_assert(sparseForces && i<atomIsForced.size());
+  if(!atomIsForced[i]) {
+    atomIsForced[i]=1;
+    forcedAtoms.push_back(i);
+  }
+}
+
 inline
 Tensor & ActionAtomistic::modifyVirial() {
   return virial;
@@ -291,12 +309,12 @@ void ActionAtomistic::unlockRequests() {
 }
 
 inline
-const std::set<AtomNumber> & ActionAtomistic::getUnique()const {
+const std::vector<AtomNumber> & ActionAtomistic::getUnique()const {
   return unique;
 }
 
 inline
-const std::set<AtomNumber> & ActionAtomistic::getUniqueLocal()const {
+const std::vector<AtomNumber> & ActionAtomistic::getUniqueLocal()const {
   return unique_local;
 }
 
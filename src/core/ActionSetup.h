@@ -37,6 +37,7 @@ public:
   explicit ActionSetup(const ActionOptions&ao);
 /// Creator of keywords
   static void registerKeywords( Keywords& keys );
+  bool checkIsStateless()const {return true;}
 /// Do nothing.
   void calculate() {}
 /// Do nothing.
@@ -38,6 +38,7 @@ protected:
   const std::string & getShortcutLabel() const ;
 public:
   static void registerKeywords( Keywords& keys );
+  bool checkIsStateless()const {return true;}
 /// Constructor
   explicit ActionShortcut(const ActionOptions&ao);
 /// Read a line of input and create appropriate actions
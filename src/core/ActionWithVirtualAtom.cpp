@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "ActionWithVirtualAtom.h"
 #include "Atoms.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -35,6 +36,7 @@ void ActionWithVirtualAtom::registerKeywords(Keywords& keys) {
 ActionWithVirtualAtom::ActionWithVirtualAtom(const ActionOptions&ao):
   Action(ao),
   ActionAtomistic(ao),
+  isotropic(false),
   boxDerivatives(3)
 {
   index=atoms.addVirtualAtom(this);
@@ -47,7 +49,8 @@ ActionWithVirtualAtom::~ActionWithVirtualAtom() {
 
 void ActionWithVirtualAtom::apply() {
   Vector & f(atoms.forces[index.index()]);
-  for(unsigned i=0; i<getNumberOfAtoms(); i++) modifyForces()[i]=matmul(derivatives[i],f);
+  if(isotropic) for(unsigned i=0; i<getNumberOfAtoms(); i++) modifyForces()[i]=weightDerivatives[i]*f;
+  else for(unsigned i=0; i<getNumberOfAtoms(); i++) modifyForces()[i]=matmul(derivatives[i],f);
   Tensor & v(modifyVirial());
   for(unsigned i=0; i<3; i++) v+=boxDerivatives[i]*f[i];
   f.zero(); // after propagating the force to the atoms used to compute the vatom, we reset this to zero
@@ -57,7 +60,8 @@ void ActionWithVirtualAtom::apply() {
 
 void ActionWithVirtualAtom::requestAtoms(const std::vector<AtomNumber> & a) {
   ActionAtomistic::requestAtoms(a);
-  derivatives.resize(a.size());
+  if(isotropic) weightDerivatives.resize(a.size());
+  else derivatives.resize(a.size());
 }
 
 void ActionWithVirtualAtom::setGradients() {
@@ -68,13 +72,24 @@ void ActionWithVirtualAtom::setGradients() {
     if(atoms.isVirtualAtom(an)) {
       const ActionWithVirtualAtom* a=atoms.getVirtualAtomsAction(an);
       for(const auto & p : a->gradients) {
-        gradients[p.first]+=matmul(derivatives[i],p.second);
+        if(isotropic) gradients.push_back(std::make_pair(p.first,weightDerivatives[i]*p.second));
+        else gradients.push_back(std::make_pair(p.first,matmul(derivatives[i],p.second)));
       }
       // this case if the atom is a normal one
     } else {
-      gradients[an]+=derivatives[i];
+      if(isotropic) gradients.push_back(std::make_pair(an,weightDerivatives[i]*Tensor::identity()));
+      else gradients.push_back(std::make_pair(an,derivatives[i]));
     }
   }
+// sort by atom number and sum the contributions to the same atom
+  std::stable_sort(gradients.begin(),gradients.end(),
+  [](const std::pair<AtomNumber,Tensor> & a,const std::pair<AtomNumber,Tensor> & b) {return a.first<b.first;});
+  unsigned n=0;
+  for(unsigned i=0; i<gradients.size(); i++) {
+    if(n>0 && gradients[n-1].first==gradients[i].first) gradients[n-1].second+=gradients[i].second;
+    else gradients[n++]=gradients[i];
+  }
+  gradients.resize(n);
 }
 
 void ActionWithVirtualAtom::setBoxDerivatives(const std::vector<Tensor> &d) {
@@ -94,8 +109,12 @@ void ActionWithVirtualAtom::setBoxDerivativesNoPbc() {
 // Indeed, we have the negative of a sum over dependent atoms (l) of the external product between positions
 // and derivatives. Notice that this only works only when Pbc have not been used to compute
 // derivatives.
-        for(unsigned l=0; l<getNumberOfAtoms(); l++) {
-          bd[k][i][j]-=getPosition(l)[i]*derivatives[l][j][k];
+        if(isotropic) {
+          if(j==k) for(unsigned l=0; l<getNumberOfAtoms(); l++) bd[k][i][j]-=getPosition(l)[i]*weightDerivatives[l];
+        } else {
+          for(unsigned l=0; l<getNumberOfAtoms(); l++) {
+            bd[k][i][j]-=getPosition(l)[i]*derivatives[l][j][k];
+          }
         }
       }
   setBoxDerivatives(bd);
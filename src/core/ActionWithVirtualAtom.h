@@ -41,9 +41,14 @@ class ActionWithVirtualAtom:
   public ActionAtomistic
 {
   AtomNumber index;
+/// True if the derivative wrt each atom is a scalar weight times the identity
+  bool isotropic;
   std::vector<Tensor> derivatives;
+/// Weights of the atoms (only used when isotropic)
+  std::vector<double> weightDerivatives;
   std::vector<Tensor> boxDerivatives;
-  std::map<AtomNumber,Tensor> gradients;
+/// Gradients wrt the real atoms, sorted by atom number
+  std::vector<std::pair<AtomNumber,Tensor> > gradients;
   void apply();
 protected:
 /// Set position of the virtual atom
@@ -56,6 +61,10 @@ protected:
   void requestAtoms(const std::vector<AtomNumber> & a);
 /// Set the derivatives of virtual atom coordinate wrt atoms on which it dependes
   void setAtomsDerivatives(const std::vector<Tensor> &d);
+/// Set the derivatives of virtual atom coordinate wrt atoms on which it dependes
+/// when they are proportional to the identity (e.g. vatom::Center).
+/// w[i] is the weight of atom i in the position of the virtual atom
+  void setAtomsDerivatives(const std::vector<double> &w);
 /// Set the box derivatives.
 /// This should be a vector of size 3. First index corresponds
 /// to the components of the virtual atom.
@@ -75,7 +84,8 @@ protected:
   void setBoxDerivativesNoPbc();
 public:
   void setGradients();
-  const std::map<AtomNumber,Tensor> & getGradients()const;
+  bool checkIsStateless()const {return true;}
+  const std::vector<std::pair<AtomNumber,Tensor> > & getGradients()const;
 /// Return the atom id of the corresponding virtual atom
   AtomNumber getIndex()const;
   explicit ActionWithVirtualAtom(const ActionOptions&ao);
@@ -106,11 +116,25 @@ void ActionWithVirtualAtom::setCharge(double c) {
 
 inline
 void ActionWithVirtualAtom::setAtomsDerivatives(const std::vector<Tensor> &d) {
+  if(isotropic) {
+    isotropic=false;
+    std::vector<double>().swap(weightDerivatives);
+  }
   derivatives=d;
 }
 
 inline
-const std::map<AtomNumber,Tensor> & ActionWithVirtualAtom::getGradients()const {
+void ActionWithVirtualAtom::setAtomsDerivatives(const std::vector<double> &w) {
+// the tensors allocated by requestAtoms() are released when switching to isotropic mode
+  if(!isotropic) {
+    isotropic=true;
+    std::vector<Tensor>().swap(derivatives);
+  }
+  weightDerivatives=w;
+}
+
+inline
+const std::vector<std::pair<AtomNumber,Tensor> > & ActionWithVirtualAtom::getGradients()const {
   return gradients;
 }
 
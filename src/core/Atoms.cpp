@@ -24,6 +24,7 @@
 #include "MDAtoms.h"
 #include "PlumedMain.h"
 #include "tools/Pbc.h"
+#include "tools/OpenMP.h"
 #include <algorithm>
 #include <iostream>
 #include <string>
@@ -145,12 +146,23 @@ void Atoms::share() {
   }
 
   if(!(int(gatindex.size())==natoms && shuffledAtoms==0)) {
+    // atoms of actions that have been deactivated should not be shared anymore
+    for(unsigned i=0; i<actions.size(); i++) {
+      if(actionsInUnique[i] && !actions[i]->isActive()) {
+        clearUnique();
+        break;
+      }
+    }
     for(unsigned i=0; i<actions.size(); i++) {
       if(actions[i]->isActive()) {
         if(!actions[i]->getUnique().empty()) {
           atomsNeeded=true;
           // unique are the local atoms
-          unique.insert(actions[i]->getUniqueLocal().begin(),actions[i]->getUniqueLocal().end());
+          // the list of each action is only merged once after it has been changed
+          if(!actionsInUnique[i]) {
+            mergeUnique(actions[i]->getUniqueLocal());
+            actionsInUnique[i]=true;
+          }
         }
       }
     }
@@ -169,25 +181,46 @@ void Atoms::share() {
 }
 
 void Atoms::shareAll() {
-  unique.clear();
+  clearUnique();
   // keep in unique only those atoms that are local
   if(dd && shuffledAtoms>0) {
-    for(int i=0; i<natoms; i++) if(g2l[i]>=0) unique.insert(AtomNumber::index(i));
+    for(int i=0; i<natoms; i++) if(g2l[i]>=0) { unique.push_back(AtomNumber::index(i)); uniqueMask[i]=true; }
   } else {
-    for(int i=0; i<natoms; i++) unique.insert(AtomNumber::index(i));
+    for(int i=0; i<natoms; i++) { unique.push_back(AtomNumber::index(i)); uniqueMask[i]=true; }
   }
   atomsNeeded=true;
   share(unique);
 }
 
-void Atoms::share(const std::set<AtomNumber>& unique) {
+void Atoms::clearUnique() {
+  if(uniqueMask.size()!=unsigned(natoms)) uniqueMask.assign(natoms,false);
+  else for(const auto & p : unique) uniqueMask[p.index()]=false;
+  unique.clear();
+  actionsInUnique.assign(actions.size(),false);
+}
+
+void Atoms::mergeUnique(const std::vector<AtomNumber>& list) {
+  if(uniqueMask.size()!=unsigned(natoms)) clearUnique();
+  const auto nold=unique.size();
+  for(const auto & p : list) {
+    if(!uniqueMask[p.index()]) {
+      uniqueMask[p.index()]=true;
+      unique.push_back(p);
+    }
+  }
+  // both the old list and the newly added atoms are sorted
+  if(unique.size()>nold && nold>0) std::inplace_merge(unique.begin(),unique.begin()+nold,unique.end());
+}
+
+void Atoms::share(const std::vector<AtomNumber>& unique) {
   plumed_assert( positionsHaveBeenSet==3 && massesHaveBeenSet );
 
   virial.zero();
   if(zeroallforces || int(gatindex.size())==natoms) {
     for(int i=0; i<natoms; i++) forces[i].zero();
   } else {
-    for(const auto & p : unique) forces[p.index()].zero();
+    #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(unique))
+    for(unsigned k=0; k<unique.size(); ++k) forces[unique[k].index()].zero();
   }
   for(unsigned i=getNatoms(); i<positions.size(); i++) forces[i].zero(); // virtual atoms
   forceOnEnergy=0.0;
@@ -224,17 +257,18 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
       for(unsigned i=0; i<dd.mpi_request_positions.size(); i++) dd.mpi_request_positions[i].wait();
       for(unsigned i=0; i<dd.mpi_request_index.size(); i++)     dd.mpi_request_index[i].wait();
     }
-    int count=0;
-    for(const auto & p : unique) {
-      dd.indexToBeSent[count]=p.index();
-      dd.positionsToBeSent[ndata*count+0]=positions[p.index()][0];
-      dd.positionsToBeSent[ndata*count+1]=positions[p.index()][1];
-      dd.positionsToBeSent[ndata*count+2]=positions[p.index()][2];
+    const int count=unique.size();
+    #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(dd.positionsToBeSent))
+    for(int k=0; k<count; k++) {
+      const unsigned p=unique[k].index();
+      dd.indexToBeSent[k]=p;
+      dd.positionsToBeSent[ndata*k+0]=positions[p][0];
+      dd.positionsToBeSent[ndata*k+1]=positions[p][1];
+      dd.positionsToBeSent[ndata*k+2]=positions[p][2];
       if(!massAndChargeOK) {
-        dd.positionsToBeSent[ndata*count+3]=masses[p.index()];
-        dd.positionsToBeSent[ndata*count+4]=charges[p.index()];
+        dd.positionsToBeSent[ndata*k+3]=masses[p];
+        dd.positionsToBeSent[ndata*k+4]=charges[p];
       }
-      count++;
     }
     if(dd.async) {
       asyncSent=true;
@@ -258,15 +292,22 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
       dd.Allgatherv(&dd.indexToBeSent[0],count,&dd.indexToBeReceived[0],&counts[0],&displ[0]);
       dd.Allgatherv(&dd.positionsToBeSent[0],ndata*count,&dd.positionsToBeReceived[0],&counts5[0],&displ5[0]);
       int tot=displ[n-1]+counts[n-1];
-      for(int i=0; i<tot; i++) {
-        positions[dd.indexToBeReceived[i]][0]=dd.positionsToBeReceived[ndata*i+0];
-        positions[dd.indexToBeReceived[i]][1]=dd.positionsToBeReceived[ndata*i+1];
-        positions[dd.indexToBeReceived[i]][2]=dd.positionsToBeReceived[ndata*i+2];
-        if(!massAndChargeOK) {
-          masses[dd.indexToBeReceived[i]]      =dd.positionsToBeReceived[ndata*i+3];
-          charges[dd.indexToBeReceived[i]]     =dd.positionsToBeReceived[ndata*i+4];
-        }
-      }
+      unpackPositions(tot,ndata);
+    }
+  }
+}
+
+void Atoms::unpackPositions(int count,int ndata) {
+// each atom is received from a single process, so threads never write on the same element
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(dd.positionsToBeReceived))
+  for(int i=0; i<count; i++) {
+    const int p=dd.indexToBeReceived[i];
+    positions[p][0]=dd.positionsToBeReceived[ndata*i+0];
+    positions[p][1]=dd.positionsToBeReceived[ndata*i+1];
+    positions[p][2]=dd.positionsToBeReceived[ndata*i+2];
+    if(!massAndChargeOK) {
+      masses[p]      =dd.positionsToBeReceived[ndata*i+3];
+      charges[p]     =dd.positionsToBeReceived[ndata*i+4];
     }
   }
 }
@@ -295,15 +336,7 @@ void Atoms::wait() {
         dd.Recv(&dd.positionsToBeReceived[ndata*count],dd.positionsToBeReceived.size()-ndata*count,i,667);
         count+=c;
       }
-      for(int i=0; i<count; i++) {
-        positions[dd.indexToBeReceived[i]][0]=dd.positionsToBeReceived[ndata*i+0];
-        positions[dd.indexToBeReceived[i]][1]=dd.positionsToBeReceived[ndata*i+1];
-        positions[dd.indexToBeReceived[i]][2]=dd.positionsToBeReceived[ndata*i+2];
-        if(!massAndChargeOK) {
-          masses[dd.indexToBeReceived[i]]      =dd.positionsToBeReceived[ndata*i+3];
-          charges[dd.indexToBeReceived[i]]     =dd.positionsToBeReceived[ndata*i+4];
-        }
-      }
+      unpackPositions(count,ndata);
       asyncSent=false;
     }
     if(collectEnergy) dd.Sum(energy);
@@ -342,11 +375,13 @@ void Atoms::setNatoms(int n) {
 
 void Atoms::add(ActionAtomistic*a) {
   actions.push_back(a);
+  actionsInUnique.push_back(false);
 }
 
 void Atoms::remove(ActionAtomistic*a) {
   auto f=find(actions.begin(),actions.end(),a);
   plumed_massert(f!=actions.end(),"cannot remove an action registered to atoms");
+  actionsInUnique.erase(actionsInUnique.begin()+(f-actions.begin()));
   actions.erase(f);
 }
 
@@ -405,7 +440,7 @@ void Atoms::setAtomsGatindex(int*g,bool fortran) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setAtomsContiguous(int start) {
@@ -418,7 +453,7 @@ void Atoms::setAtomsContiguous(int start) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setRealPrecision(int p) {
@@ -466,13 +501,13 @@ void Atoms::createFullList(int*n) {
 // We update here the unique list defined at Atoms::unique.
 // This is not very clear, and probably should be coded differently.
 // Hopefully this fix the longstanding issue with NAMD.
-    unique.clear();
+    clearUnique();
     for(unsigned i=0; i<actions.size(); i++) {
       if(actions[i]->isActive()) {
         if(!actions[i]->getUnique().empty()) {
           atomsNeeded=true;
           // unique are the local atoms
-          unique.insert(actions[i]->getUnique().begin(),actions[i]->getUnique().end());
+          mergeUnique(actions[i]->getUnique());
         }
       }
     }
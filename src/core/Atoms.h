@@ -49,7 +49,12 @@ class Atoms
   friend class ActionAtomistic;
   friend class ActionWithVirtualAtom;
   int natoms;
-  std::set<AtomNumber> unique;
+/// Sorted list of the (local) atoms requested by the active actions
+  std::vector<AtomNumber> unique;
+/// Flags marking the atoms that are in unique
+  std::vector<bool> uniqueMask;
+/// Flags marking the actions whose atoms have been merged in unique
+  std::vector<bool> actionsInUnique;
   std::vector<unsigned> uniq_index;
 /// Map global indexes to local indexes
 /// E.g. g2l[i] is the position of atom i in the array passed from the MD engine.
@@ -139,7 +144,13 @@ class Atoms
   DomainDecomposition dd;
   long int ddStep;  //last step in which dd happened
 
-  void share(const std::set<AtomNumber>&);
+  void share(const std::vector<AtomNumber>&);
+/// Empty the list of requested atoms, which will be rebuilt at the next share
+  void clearUnique();
+/// Merge a sorted list of atoms in unique
+  void mergeUnique(const std::vector<AtomNumber>&);
+/// Copy the first count atoms received from the other processes in positions (and masses and charges if ndata==5)
+  void unpackPositions(int count,int ndata);
 
 public:
 
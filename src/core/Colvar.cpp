@@ -31,9 +31,12 @@ Colvar::Colvar(const ActionOptions&ao):
   Action(ao),
   ActionAtomistic(ao),
   ActionWithValue(ao),
+  sparseDerivatives(false),
   isEnergy(false),
   isExtraCV(false)
 {
+  if( keywords.exists("SPARSE_DERIVATIVES") ) parseFlag("SPARSE_DERIVATIVES",sparseDerivatives);
+  if( sparseDerivatives ) log.printf("  keeping track only of the derivatives with respect to the atoms that contribute\n");
 }
 
 void Colvar::registerKeywords( Keywords& keys ) {
@@ -41,6 +44,8 @@ void Colvar::registerKeywords( Keywords& keys ) {
   ActionWithValue::registerKeywords( keys );
   ActionAtomistic::registerKeywords( keys );
   keys.addFlag("NOPBC",false,"ignore the periodic boundary conditions when calculating distances");
+  keys.addFlag("SPARSE_DERIVATIVES",false,"only keep track of the derivatives with respect to the atoms that contribute to the colvar. "
+               "This makes clearing the derivatives and applying the forces cheaper when only a few of a large number of atoms contribute");
 }
 
 void Colvar::requestAtoms(const vector<AtomNumber> & a) {
@@ -48,7 +53,10 @@ void Colvar::requestAtoms(const vector<AtomNumber> & a) {
 // Tell actionAtomistic what atoms we are getting
   ActionAtomistic::requestAtoms(a);
 // Resize the derivatives of all atoms
-  for(int i=0; i<getNumberOfComponents(); ++i) getPntrToComponent(i)->resizeDerivatives(3*a.size()+9);
+  for(int i=0; i<getNumberOfComponents(); ++i) {
+    getPntrToComponent(i)->setSparseDerivatives(sparseDerivatives);
+    getPntrToComponent(i)->resizeDerivatives(3*a.size()+9);
+  }
 }
 
 void Colvar::apply() {
@@ -68,7 +76,12 @@ void Colvar::apply() {
   unsigned nt=OpenMP::getNumThreads();
   if(nt>ncp/(4*stride)) nt=1;
 
-  if(!isEnergy && !isExtraCV) {
+  bool sparse=sparseDerivatives;
+  for(unsigned i=0; i<ncp; ++i) if(!getPntrToComponent(i)->hasSparseDerivatives()) sparse=false;
+
+  if(!isEnergy && !isExtraCV && sparse) {
+    applySparse();
+  } else if(!isEnergy && !isExtraCV) {
     #pragma omp parallel num_threads(nt)
     {
       vector<Vector> omp_f(fsz);
@@ -114,6 +127,29 @@ void Colvar::apply() {
   }
 }
 
+void Colvar::applySparse() {
+  vector<Vector>&   f(modifyForces());
+  Tensor&           v(modifyVirial());
+  const unsigned    nat=getNumberOfAtoms();
+  const unsigned    ncp=getNumberOfComponents();
+
+  useSparseForces();
+  for(unsigned i=0; i<ncp; ++i) {
+    const Value* val=getPntrToComponent(i);
+    if(!val->forceWasAdded()) continue;
+    const double force=val->getForce();
+    for(const auto & k : val->getActiveDerivatives()) {
+      const double fk=force*val->getDerivative(k);
+      if(k<3*nat) {
+        f[k/3][k%3]+=fk;
+        markForcedAtom(k/3);
+      } else {
+        v[(k-3*nat)/3][(k-3*nat)%3]+=fk;
+      }
+    }
+  }
+}
+
 void Colvar::setBoxDerivativesNoPbc(Value* v) {
   Tensor virial;
   unsigned nat=getNumberOfAtoms();
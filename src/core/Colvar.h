@@ -41,6 +41,10 @@ class Colvar :
   public ActionWithValue
 {
 private:
+/// Only keep track of the derivatives with respect to the atoms that contribute
+  bool sparseDerivatives;
+/// Apply the forces using only the derivatives that have been set
+  void applySparse();
 protected:
   bool isEnergy;
   bool isExtraCV;
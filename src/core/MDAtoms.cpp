@@ -51,6 +51,8 @@ class MDAtomsTyped:
   T *virial;
   std::map<std::string,T*> extraCV;
   std::map<std::string,T*> extraCVForce;
+/// Are positions stored as a single array x0 y0 z0 x1 y1 z1 ...
+  bool positionsAreInterleaved() const { return stride==3 && py==px+1 && pz==px+2; }
 public:
   MDAtomsTyped();
   void setm(void*m);
@@ -86,14 +88,14 @@ public:
   }
   void getBox(Tensor &)const;
   void getPositions(const vector<int>&index,vector<Vector>&positions)const;
-  void getPositions(const std::set<AtomNumber>&index,const vector<unsigned>&i,vector<Vector>&positions)const;
+  void getPositions(const std::vector<AtomNumber>&index,const vector<unsigned>&i,vector<Vector>&positions)const;
   void getPositions(unsigned j,unsigned k,vector<Vector>&positions)const;
   void getLocalPositions(std::vector<Vector>&p)const;
   void getMasses(const vector<int>&index,vector<double>&)const;
   void getCharges(const vector<int>&index,vector<double>&)const;
   void updateVirial(const Tensor&)const;
   void updateForces(const vector<int>&index,const vector<Vector>&);
-  void updateForces(const std::set<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces);
+  void updateForces(const std::vector<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces);
   void rescaleForces(const vector<int>&index,double factor);
   unsigned  getRealPrecision()const;
 };
@@ -122,7 +124,8 @@ void MDAtomsTyped<T>::getBox(Tensor&box)const {
 
 template <class T>
 void MDAtomsTyped<T>::getPositions(const vector<int>&index,vector<Vector>&positions)const {
-// cannot be parallelized with omp because access to positions is not ordered
+// indexes are all different, so threads never write on the same element of positions
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(px,stride*index.size()))
   for(unsigned i=0; i<index.size(); ++i) {
     positions[index[i]][0]=px[stride*i]*scalep;
     positions[index[i]][1]=py[stride*i]*scalep;
@@ -131,19 +134,27 @@ void MDAtomsTyped<T>::getPositions(const vector<int>&index,vector<Vector>&positi
 }
 
 template <class T>
-void MDAtomsTyped<T>::getPositions(const std::set<AtomNumber>&index,const vector<unsigned>&i, vector<Vector>&positions)const {
-// cannot be parallelized with omp because access to positions is not ordered
-  unsigned k=0;
-  for(const auto & p : index) {
-    positions[p.index()][0]=px[stride*i[k]]*scalep;
-    positions[p.index()][1]=py[stride*i[k]]*scalep;
-    positions[p.index()][2]=pz[stride*i[k]]*scalep;
-    k++;
+void MDAtomsTyped<T>::getPositions(const std::vector<AtomNumber>&index,const vector<unsigned>&i, vector<Vector>&positions)const {
+// indexes are all different, so threads never write on the same element of positions
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(px,stride*index.size()))
+  for(unsigned k=0; k<index.size(); ++k) {
+    const unsigned p=index[k].index();
+    positions[p][0]=px[stride*i[k]]*scalep;
+    positions[p][1]=py[stride*i[k]]*scalep;
+    positions[p][2]=pz[stride*i[k]]*scalep;
   }
 }
 
 template <class T>
 void MDAtomsTyped<T>::getPositions(unsigned j,unsigned k,vector<Vector>&positions)const {
+  if(k<=j) return;
+  if(positionsAreInterleaved()) {
+// both arrays are contiguous, so that the conversion can be vectorized
+    const T* p=px+3*j; double* q=&positions[j][0]; const unsigned n=3*(k-j);
+    #pragma omp parallel for simd num_threads(OpenMP::getGoodNumThreads(q,n))
+    for(unsigned l=0; l<n; ++l) q[l]=p[l]*scalep;
+    return;
+  }
   #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(&positions[j],(k-j)))
   for(unsigned i=j; i<k; ++i) {
     positions[i][0]=px[stride*i]*scalep;
@@ -155,6 +166,13 @@ void MDAtomsTyped<T>::getPositions(unsigned j,unsigned k,vector<Vector>&position
 
 template <class T>
 void MDAtomsTyped<T>::getLocalPositions(vector<Vector>&positions)const {
+  if(positions.size()>0 && positionsAreInterleaved()) {
+// both arrays are contiguous, so that the conversion can be vectorized
+    double* q=&positions[0][0]; const unsigned n=3*positions.size();
+    #pragma omp parallel for simd num_threads(OpenMP::getGoodNumThreads(q,n))
+    for(unsigned l=0; l<n; ++l) q[l]=px[l]*scalep;
+    return;
+  }
   #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(positions))
   for(unsigned i=0; i<positions.size(); ++i) {
     positions[i][0]=px[stride*i]*scalep;
@@ -166,14 +184,14 @@ void MDAtomsTyped<T>::getLocalPositions(vector<Vector>&positions)const {
 
 template <class T>
 void MDAtomsTyped<T>::getMasses(const vector<int>&index,vector<double>&masses)const {
-  if(m) for(unsigned i=0; i<index.size(); ++i) masses[index[i]]=scalem*m[i];
-  else  for(unsigned i=0; i<index.size(); ++i) masses[index[i]]=0.0;
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(index))
+  for(unsigned i=0; i<index.size(); ++i) masses[index[i]]=(m?scalem*m[i]:0.0);
 }
 
 template <class T>
 void MDAtomsTyped<T>::getCharges(const vector<int>&index,vector<double>&charges)const {
-  if(c) for(unsigned i=0; i<index.size(); ++i) charges[index[i]]=scalec*c[i];
-  else  for(unsigned i=0; i<index.size(); ++i) charges[index[i]]=0.0;
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(index))
+  for(unsigned i=0; i<index.size(); ++i) charges[index[i]]=(c?scalec*c[i]:0.0);
 }
 
 template <class T>
@@ -182,13 +200,14 @@ void MDAtomsTyped<T>::updateVirial(const Tensor&virial)const {
 }
 
 template <class T>
-void MDAtomsTyped<T>::updateForces(const std::set<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces) {
-  unsigned k=0;
-  for(const auto & p : index) {
-    fx[stride*i[k]]+=scalef*T(forces[p.index()][0]);
-    fy[stride*i[k]]+=scalef*T(forces[p.index()][1]);
-    fz[stride*i[k]]+=scalef*T(forces[p.index()][2]);
-    k++;
+void MDAtomsTyped<T>::updateForces(const std::vector<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces) {
+// local indexes are all different, so threads never write on the same element of the forces
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(fx,stride*index.size()))
+  for(unsigned k=0; k<index.size(); ++k) {
+    const unsigned p=index[k].index();
+    fx[stride*i[k]]+=scalef*T(forces[p][0]);
+    fy[stride*i[k]]+=scalef*T(forces[p][1]);
+    fz[stride*i[k]]+=scalef*T(forces[p][2]);
   }
 }
 
@@ -37,6 +37,7 @@
 #include "tools/Exception.h"
 #include "tools/IFile.h"
 #include "tools/Log.h"
+#include "tools/OFile.h"
 #include "tools/OpenMP.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
@@ -44,6 +45,7 @@
 #include "DataFetchingObject.h"
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <set>
 #include <unordered_map>
 #include <exception>
@@ -139,7 +141,9 @@ PlumedMain::PlumedMain():
   stopFlag(NULL),
   stopNow(false),
   novirial(false),
-  detailedTimers(false)
+  detailedTimers(false),
+  asyncTask(false),
+  asyncStop(false)
 {
   log.link(comm);
   log.setLinePrefix("PLUMED: ");
@@ -147,6 +151,16 @@ PlumedMain::PlumedMain():
 
 // destructor needed to delete forward declarated objects
 PlumedMain::~PlumedMain() {
+// the thread running the asynchronous calculations should not outlive the object
+  if(asyncWorker.joinable()) {
+    if(asyncCalc.valid()) asyncCalc.wait();
+    {
+      std::lock_guard<std::mutex> lock(asyncMutex);
+      asyncStop=true;
+    }
+    asyncCond.notify_one();
+    asyncWorker.join();
+  }
 }
 
 /////////////////////////////////////////////////////////////
@@ -169,19 +183,49 @@ void PlumedMain::cmd(const std::string & word,void*val) {
 #include "PlumedMainMap.inc"
   };
 
+// Commands that read additional words from the string and thus cannot be passed as a handle:
+  auto needsWords=[](int iword) {
+    return iword==cmd_getDataRank || iword==cmd_getDataShape || iword==cmd_setMemoryForData ||
+           iword==cmd_checkAction || iword==cmd_setExtraCV || iword==cmd_setExtraCVForce ||
+           iword==cmd_GREX || iword==cmd_CLTool || iword==cmd_getCommandHandle;
+  };
+
   try {
 
+// an asynchronous calculation is completed before any other command touches plumed data.
+// commands issued by the actions from within the calculation itself (e.g. DEBUG logRequestedAtoms)
+// are executed directly, as they would be in a synchronous calculation
+    if(asyncCalc.valid() && asyncThread!=std::this_thread::get_id()) waitForces();
+
     auto ss=stopwatch.startPause();
 
-    std::vector<std::string> words=Tools::getWords(word);
-    unsigned nw=words.size();
+    std::vector<std::string> words;
+    unsigned nw=0;
+    int iword=-1;
+    if(word.length()>1 && word[0]=='#') {
+      // handle obtained with getCommandHandle: no need to split the string and search the map
+      char* end;
+      long h=std::strtol(word.c_str()+1,&end,10);
+      plumed_massert(*end=='\0' && h>=0 && h<static_cast<long>(word_map.size()) && !needsWords(h),"cmd(\"" + word + "\") is not a valid command handle");
+      nw=1; iword=h;
+    } else if(word.find_first_of(" \t\n{}")==std::string::npos) {
+      // single words are searched directly without splitting the string
+      if(word.length()>0) nw=1;
+      const auto it=word_map.find(word);
+      if(it!=word_map.end()) iword=it->second;
+      if(needsWords(iword)) words.push_back(word);
+    } else {
+      words=Tools::getWords(word);
+      nw=words.size();
+      if(nw>0) {
+        const auto it=word_map.find(words[0]);
+        if(it!=word_map.end()) iword=it->second;
+      }
+    }
     if(nw==0) {
       // do nothing
     } else {
-      int iword=-1;
       double d;
-      const auto it=word_map.find(words[0]);
-      if(it!=word_map.end()) iword=it->second;
       switch(iword) {
       case cmd_setBox:
         CHECK_INIT(initialized,word);
@@ -266,6 +310,16 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         CHECK_INIT(initialized,word);
         update();
         break;
+      /* ADDED WITH API==8 */
+      case cmd_performCalcAsync:
+        CHECK_INIT(initialized,word);
+        performCalcAsync();
+        break;
+      /* ADDED WITH API==8 */
+      case cmd_waitForces:
+        CHECK_INIT(initialized,word);
+// nothing else to do, the calculation has been completed above
+        break;
       case cmd_setStep:
         CHECK_INIT(initialized,word);
         CHECK_NOTNULL(val,word);
@@ -352,7 +406,18 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         break;
       case cmd_getApiVersion:
         CHECK_NOTNULL(val,word);
-        *(static_cast<int*>(val))=6;
+        *(static_cast<int*>(val))=8;
+        break;
+      /* ADDED WITH API==7 */
+      case cmd_getCommandHandle:
+        CHECK_NOTNULL(val,word);
+        plumed_assert(nw==2);
+        {
+          const auto it=word_map.find(words[1]);
+          plumed_massert(it!=word_map.end(),"cannot get a handle for unknown command " + words[1]);
+          plumed_massert(!needsWords(it->second),"cannot get a handle for command " + words[1] + " since it requires additional arguments");
+          *(static_cast<int*>(val))=it->second;
+        }
         break;
       // commands which can be used only before initialization:
       case cmd_init:
@@ -747,6 +812,50 @@ void PlumedMain::performCalc() {
   mydatafetcher->finishDataGrab();
 }
 
+void PlumedMain::performCalcAsync() {
+// when the energy is needed all the MD forces might be rescaled,
+// so the calculation cannot overlap with the one of the MD code
+  if(!active || atoms.isEnergyNeeded()) {
+    performCalc();
+    return;
+  }
+// actions are free to use OpenMP from within the worker thread
+  if(!asyncWorker.joinable()) {
+    asyncWorker=std::thread(&PlumedMain::asyncLoop,this);
+    asyncThread=asyncWorker.get_id();
+  }
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex);
+    asyncPromise=std::promise<void>();
+    asyncCalc=asyncPromise.get_future();
+    asyncTask=true;
+  }
+  asyncCond.notify_one();
+}
+
+void PlumedMain::asyncLoop() {
+  std::unique_lock<std::mutex> lock(asyncMutex);
+  while(true) {
+    asyncCond.wait(lock,[this]() {return asyncTask || asyncStop;});
+    if(!asyncTask) return;
+    asyncTask=false;
+    std::promise<void> done(std::move(asyncPromise));
+    lock.unlock();
+    try {
+      performCalc();
+      done.set_value();
+    } catch(...) {
+      done.set_exception(std::current_exception());
+    }
+    lock.lock();
+  }
+}
+
+void PlumedMain::waitForces() {
+// get() rethrows exceptions raised during the calculation
+  if(asyncCalc.valid()) asyncCalc.get();
+}
+
 void PlumedMain::waitData() {
   if(!active)return;
 // Stopwatch is stopped when sw goes out of scope
@@ -943,6 +1052,16 @@ void PlumedMain::fflush() {
   }
 }
 
+std::vector<std::string> PlumedMain::getOutputFiles()const {
+  std::vector<std::string> paths;
+  for(const auto & p : files) {
+    if(dynamic_cast<OFile*>(p)) paths.push_back(p->getPath());
+  }
+  std::sort(paths.begin(),paths.end());
+  paths.erase(std::unique(paths.begin(),paths.end()),paths.end());
+  return paths;
+}
+
 void PlumedMain::insertFile(FileBase&f) {
   files.insert(&f);
 }
@@ -31,6 +31,10 @@
 #include <stack>
 #include <memory>
 #include <map>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 // !!!!!!!!!!!!!!!!!!!!!!    DANGER   !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!11
 // THE FOLLOWING ARE DEFINITIONS WHICH ARE NECESSARY FOR DYNAMIC LOADING OF THE PLUMED KERNEL:
@@ -199,6 +203,27 @@ private:
 /// Store information used in class \ref generic::UpdateIf
   std::stack<bool> updateFlags;
 
+/// Thread running the calculations started with performCalcAsync().
+/// It is started at the first call and kept until the object is destroyed,
+/// so that the OpenMP teams of the actions are reused from one step to the next
+  std::thread asyncWorker;
+/// Id of asyncWorker, whose own calls to cmd() should not wait for the calculation
+  std::thread::id asyncThread;
+/// Protects asyncTask, asyncStop and asyncPromise
+  std::mutex asyncMutex;
+/// Used to wake up asyncWorker
+  std::condition_variable asyncCond;
+/// A calculation is waiting to be started by asyncWorker
+  bool asyncTask;
+/// asyncWorker should exit
+  bool asyncStop;
+/// Fulfilled by asyncWorker when the calculation of the current step is completed
+  std::promise<void> asyncPromise;
+/// Completion of the calculation of the current step
+  std::future<void> asyncCalc;
+/// Loop executed by asyncWorker
+  void asyncLoop();
+
 public:
 /// Flag to switch off virial calculation (for debug and MD codes with no barostat)
   bool novirial;
@@ -292,6 +317,18 @@ public:
     Shortcut for: waitData() + justCalculate() + backwardPropagate()
   */
   void performCalcNoUpdate();
+  /**
+    Perform the calculation on a separate thread.
+    Same as performCalc(), but control is returned immediately to the MD code,
+    that can compute its own forces in the meanwhile. Forces and virial are only
+    guaranteed to be applied after waitForces(), and the MD code should not touch the
+    arrays passed to plumed until then.
+  */
+  void performCalcAsync();
+  /**
+    Wait for the calculation started with performCalcAsync() to complete.
+  */
+  void waitForces();
   /**
     Complete PLUMED calculation.
     Shortcut for prepareCalc() + performCalc()
@@ -359,6 +396,8 @@ public:
   void eraseFile(FileBase&);
 /// Flush all files
   void fflush();
+/// Get the paths of the output files that are currently open
+  std::vector<std::string> getOutputFiles()const;
 /// Check if restarting
   bool getRestart()const;
 /// Set restart flag
@@ -27,6 +27,7 @@
 #include "tools/Exception.h"
 #include "Atoms.h"
 #include "PlumedMain.h"
+#include <algorithm>
 
 namespace PLMD {
 
@@ -36,6 +37,7 @@ Value::Value():
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparse(false),
   hasDeriv(true),
   periodicity(unset),
   min(0.0),
@@ -51,6 +53,7 @@ Value::Value(ActionWithValue* av, const std::string& name, const bool withderiv)
   value(0.0),
   inputForce(0.0),
   hasForce(false),
+  sparse(false),
   name(name),
   hasDeriv(withderiv),
   periodicity(unset),
@@ -80,11 +83,37 @@ bool Value::isPeriodic()const {
 bool Value::applyForce(std::vector<double>& forces ) const {
   if( !hasForce ) return false;
   plumed_dbg_massert( derivatives.size()==forces.size()," forces array has wrong size" );
+  if(sparse) {
+    std::fill(forces.begin(),forces.end(),0.0);
+    for(const auto & i : activeDerivatives) forces[i]=inputForce*derivatives[i];
+    return true;
+  }
   const unsigned N=derivatives.size();
   for(unsigned i=0; i<N; ++i) forces[i]=inputForce*derivatives[i];
   return true;
 }
 
+void Value::resizeDerivatives(int n) {
+  if(!hasDeriv) return;
+  derivatives.resize(n);
+  if(sparse) {
+    derivativeIsActive.resize(n,0);
+    activeDerivatives.erase( std::remove_if(activeDerivatives.begin(),activeDerivatives.end(),
+    [n](unsigned i) {return i>=static_cast<unsigned>(n);}), activeDerivatives.end() );
+  }
+}
+
+void Value::setSparseDerivatives(bool s) {
+  if(s==sparse) return;
+  sparse=s;
+  activeDerivatives.clear();
+  derivativeIsActive.clear();
+  if(!sparse) return;
+// the derivatives that are already non zero are the active ones
+  derivativeIsActive.assign(derivatives.size(),0);
+  for(unsigned i=0; i<derivatives.size(); ++i) if(derivatives[i]!=0.0) activateDerivative(i);
+}
+
 void Value::setNotPeriodic() {
   min=0; max=0; periodicity=notperiodic;
 }
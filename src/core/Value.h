@@ -68,6 +68,12 @@ private:
   bool hasForce;
 /// The derivatives of the quantity stored in value
   std::vector<double> derivatives;
+/// Are we only keeping track of the derivatives that have been set
+  bool sparse;
+/// The indices of the derivatives that have been set (only with sparse derivatives)
+  std::vector<unsigned> activeDerivatives;
+/// Flags telling which derivatives are in activeDerivatives
+  std::vector<char> derivativeIsActive;
   std::map<AtomNumber,Vector> gradients;
 /// The name of this quantiy
   std::string name;
@@ -84,6 +90,8 @@ private:
   void setupPeriodicity();
 // bring value within PBCs
   void applyPeriodicity();
+/// Add derivative i to the list of derivatives that have been set
+  void activateDerivative(unsigned i);
 public:
 /// A constructor that can be used to make Vectors of values
   Value();
@@ -117,6 +125,13 @@ public:
   void resizeDerivatives(int n);
 /// Set all the derivatives to zero
   void clearDerivatives();
+/// Only keep track of the derivatives that have been set since the last call to clearDerivatives.
+/// Clearing the derivatives and applying the chain rule then only involve those elements
+  void setSparseDerivatives(bool s);
+/// Check whether we only keep track of the derivatives that have been set
+  bool hasSparseDerivatives() const;
+/// Get the indices of the derivatives that have been set (only with sparse derivatives)
+  const std::vector<unsigned>& getActiveDerivatives() const;
 /// Add some derivative to the ith component of the derivatives array
   void addDerivative(unsigned i,double d);
 /// Set the value of the ith component of the derivatives array
@@ -131,6 +146,8 @@ public:
   void  addForce(double f);
 /// Get the value of the force on this colvar
   double getForce() const ;
+/// Check whether some force has been added on this value
+  bool forceWasAdded() const ;
 /// Apply the forces to the derivatives using the chain rule (if there are no forces this routine returns false)
   bool applyForce( std::vector<double>& forces ) const ;
 /// Calculate the difference between the instantaneous value of the function and some other point: other_point-inst_val
@@ -235,25 +252,45 @@ bool Value::hasDerivatives() const {
 }
 
 inline
-void Value::resizeDerivatives(int n) {
-  if(hasDeriv) derivatives.resize(n);
+bool Value::hasSparseDerivatives() const {
+  return sparse;
+}
+
+inline
+const std::vector<unsigned>& Value::getActiveDerivatives() const {
+  plumed_dbg_massert(sparse,"active derivatives are only stored with sparse derivatives");
+  return activeDerivatives;
+}
+
+inline
+void Value::activateDerivative(unsigned i) {
+  if(!derivativeIsActive[i]) {
+    derivativeIsActive[i]=1;
+    activeDerivatives.push_back(i);
+  }
 }
 
 inline
 void Value::addDerivative(unsigned i,double d) {
   plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
+  if(sparse) activateDerivative(i);
   derivatives[i]+=d;
 }
 
 inline
 void Value::setDerivative(unsigned i, double d) {
   plumed_dbg_massert(i<derivatives.size(),"derivative is out of bounds");
+  if(sparse) activateDerivative(i);
   derivatives[i]=d;
 }
 
 inline
 void Value::chainRule(double df) {
-  for(unsigned i=0; i<derivatives.size(); ++i) derivatives[i]*=df;
+  if(sparse) {
+    for(const auto & i : activeDerivatives) derivatives[i]*=df;
+  } else {
+    for(unsigned i=0; i<derivatives.size(); ++i) derivatives[i]*=df;
+  }
 }
 
 inline
@@ -265,7 +302,15 @@ void Value::clearInputForce() {
 inline
 void Value::clearDerivatives() {
   value_set=false;
-  std::fill(derivatives.begin(), derivatives.end(), 0);
+  if(sparse) {
+    for(const auto & i : activeDerivatives) {
+      derivatives[i]=0;
+      derivativeIsActive[i]=0;
+    }
+    activeDerivatives.clear();
+  } else {
+    std::fill(derivatives.begin(), derivatives.end(), 0);
+  }
 }
 
 inline
@@ -279,6 +324,11 @@ inline
 double Value::getForce() const {
   return inputForce;
 }
+
+inline
+bool Value::forceWasAdded() const {
+  return hasForce;
+}
 /// d2-d1
 inline
 double Value::difference(double d1,double d2)const {
@@ -23,6 +23,7 @@
 #include "reference/ReferenceConfiguration.h"
 #include "core/PlumedMain.h"
 #include "core/Atoms.h"
+#include "tools/Stopwatch.h"
 
 namespace PLMD {
 namespace dimred {
@@ -75,6 +76,8 @@ void DimensionalityReductionBase::getProjection( const unsigned& idata, std::vec
 
 void DimensionalityReductionBase::performAnalysis() {
   log.printf("Generating projections required by action %s \n",getLabel().c_str() );
+// Stopwatch is logged when it goes out of scope
+  Stopwatch sw(log);
   // Resize the tempory array (this is used for out of sample)
   dtargets.resize( getNumberOfDataPoints() );
   // Resize the projections array
@@ -89,11 +92,15 @@ void DimensionalityReductionBase::performAnalysis() {
   }
   // Calculate matrix of dissimilarities
   Matrix<double> targets( getNumberOfDataPoints(), getNumberOfDataPoints() ); targets=0;
+  sw.start("1 Collecting dissimilarities");
   for(unsigned i=1; i<getNumberOfDataPoints(); ++i) {
     for(unsigned j=0; j<i; ++j) targets(i,j)=targets(j,i)=getDissimilarity( i, j );
   }
+  sw.stop("1 Collecting dissimilarities");
   // This calculates the projections of the points
+  sw.start("2 Calculating projections");
   calculateProjections( targets, projections );
+  sw.stop("2 Calculating projections");
   // Now set the projection values in the underlying object
   if( my_input_data ) {
     for(unsigned idat=0; idat<getNumberOfDataPoints(); ++idat) {
@@ -20,53 +20,69 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "SMACOF.h"
+#include "tools/OpenMP.h"
 
 namespace PLMD {
 namespace dimred {
 
 void SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops, Matrix<double>& InitialZ ) {
-  unsigned M = Distances.nrows();
+  unsigned M = Distances.nrows(), nlow = InitialZ.ncols();
+  const unsigned nt=OpenMP::getNumThreads();
 
   // Calculate V
-  Matrix<double> V(M,M); double totalWeight=0.;
-  for(unsigned i=0; i<M; ++i) {
-    for(unsigned j=0; j<M; ++j) {
-      if(i==j) continue;
-      V(i,j)=-Weights(i,j);
-      if( j<i ) totalWeight+=Weights(i,j);
-    }
-    for(unsigned j=0; j<M; ++j) {
-      if(i==j)continue;
-      V(i,i)-=V(i,j);
+  Matrix<double> V(M,M);
+  // The partial sums of the threads are added in a fixed order so that the result does not depend on the scheduling
+  std::vector<double> tweight( nt, 0.0 );
+  #pragma omp parallel num_threads(nt)
+  {
+    double mytotal=0.;
+    #pragma omp for nowait
+    for(unsigned i=0; i<M; ++i) {
+      for(unsigned j=0; j<M; ++j) {
+        if(i==j) continue;
+        V(i,j)=-Weights(i,j);
+        if( j<i ) mytotal+=Weights(i,j);
+      }
+      for(unsigned j=0; j<M; ++j) {
+        if(i==j)continue;
+        V(i,i)-=V(i,j);
+      }
     }
+    tweight[OpenMP::getThreadNum()]=mytotal;
   }
+  double totalWeight=0.;
+  for(unsigned t=0; t<nt; ++t) totalWeight+=tweight[t];
 
   // And pseudo invert V
   Matrix<double> mypseudo(M, M); pseudoInvert(V, mypseudo);
   Matrix<double> dists( M, M ); double myfirstsig = calculateSigma( Weights, Distances, InitialZ, dists ) / totalWeight;
 
   // initial sigma is made up of the original distances minus the distances between the projections all squared.
-  Matrix<double> temp( M, M ), BZ( M, M ), newZ( M, InitialZ.ncols() );
+  // BZ holds the product of the B(Z) matrix with Z, which is all we need for the Guttman transform
+  Matrix<double> BZ( M, nlow ), newZ( M, nlow );
   for(unsigned n=0; n<maxloops; ++n) {
     if(n==maxloops-1) plumed_merror("ran out of steps in SMACOF algorithm");
 
-    // Recompute BZ matrix
+    // Recompute the product of the BZ matrix with Z. As the diagonal elements of BZ are
+    // minus the sum of the off diagonal elements (Equation 8.25) we do not need to store BZ
+    #pragma omp parallel for num_threads(nt)
     for(unsigned i=0; i<M; ++i) {
+      for(unsigned k=0; k<nlow; ++k) BZ(i,k)=0.;
       for(unsigned j=0; j<M; ++j) {
-        if(i==j) continue;  //skips over the diagonal elements
-
-        if( dists(i,j)>0 ) BZ(i,j) = -Weights(i,j)*Distances(i,j) / dists(i,j);
-        else BZ(i,j)=0.;
+        if(i==j || dists(i,j)<=0 ) continue;
+        double bij = -Weights(i,j)*Distances(i,j) / dists(i,j);
+        for(unsigned k=0; k<nlow; ++k) BZ(i,k) += bij*( InitialZ(j,k) - InitialZ(i,k) );
       }
-      //the diagonal elements are -off diagonal elements BZ(i,i)-=BZ(i,j)   (Equation 8.25)
-      BZ(i,i)=0; //create the space memory for the diagonal elements which are scalars
+    }
+
+    // Guttman transform.  Multiplying V^+ by BZ Z rather than by BZ avoids an O(M^3) matrix product at every step
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned i=0; i<M; ++i) {
+      for(unsigned k=0; k<nlow; ++k) newZ(i,k)=0.;
       for(unsigned j=0; j<M; ++j) {
-        if(i==j) continue;
-        BZ(i,i)-=BZ(i,j);
+        for(unsigned k=0; k<nlow; ++k) newZ(i,k) += mypseudo(i,j)*BZ(j,k);
       }
     }
-
-    mult( mypseudo, BZ, temp); mult(temp, InitialZ, newZ);
     //Compute new sigma
     double newsig = calculateSigma( Weights, Distances, newZ, dists ) / totalWeight;
     //Computing whether the algorithm has converged (has the mass of the potato changed
@@ -78,14 +94,25 @@ void SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances
 }
 
 double SMACOF::calculateSigma( const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& InitialZ, Matrix<double>& dists ) {
-  unsigned M = Distances.nrows(); double sigma=0;
-  for(unsigned i=1; i<M; ++i) {
-    for(unsigned j=0; j<i; ++j) {
-      double dlow=0; for(unsigned k=0; k<InitialZ.ncols(); ++k) { double tmp=InitialZ(i,k) - InitialZ(j,k); dlow+=tmp*tmp; }
-      dists(i,j)=dists(j,i)=sqrt(dlow); double tmp3 = Distances(i,j) - dists(i,j);
-      sigma += Weights(i,j)*tmp3*tmp3;
+  unsigned M = Distances.nrows(); const unsigned nt=OpenMP::getNumThreads();
+  std::vector<double> tsigma( nt, 0.0 );
+  #pragma omp parallel num_threads(nt)
+  {
+    double mysigma=0;
+    // Rows are dealt cyclically to the threads so that the triangular loop is balanced
+    #pragma omp for schedule(static,1) nowait
+    for(unsigned i=1; i<M; ++i) {
+      for(unsigned j=0; j<i; ++j) {
+        double dlow=0; for(unsigned k=0; k<InitialZ.ncols(); ++k) { double tmp=InitialZ(i,k) - InitialZ(j,k); dlow+=tmp*tmp; }
+        dists(i,j)=dists(j,i)=sqrt(dlow); double tmp3 = Distances(i,j) - dists(i,j);
+        mysigma += Weights(i,j)*tmp3*tmp3;
+      }
     }
+    tsigma[OpenMP::getThreadNum()]=mysigma;
   }
+  // The partial sums are added in thread order so that the convergence test does not depend on the scheduling
+  double sigma=0;
+  for(unsigned t=0; t<nt; ++t) sigma+=tsigma[t];
   return sigma;
 }
 
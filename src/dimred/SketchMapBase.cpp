@@ -20,6 +20,7 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "SketchMapBase.h"
+#include "tools/OpenMP.h"
 
 namespace PLMD {
 namespace dimred {
@@ -88,10 +89,11 @@ void SketchMapBase::calculateProjections( const Matrix<double>& targets, Matrix<
   normw*=normw;
 
   // Transform the high dimensional distances
-  double df; distances=0.; transformed=0.;
+  distances=0.; transformed=0.;
+  #pragma omp parallel for num_threads(OpenMP::getNumThreads()) schedule(static,1)
   for(unsigned i=1; i<distances.ncols(); ++i) {
     for(unsigned j=0; j<i; ++j) {
-      distances(i,j)=distances(j,i)=sqrt( targets(i,j) );
+      double df; distances(i,j)=distances(j,i)=sqrt( targets(i,j) );
       transformed(i,j)=transformed(j,i)=transformHighDimensionalDistance( distances(i,j), df );
     }
   }
@@ -102,60 +104,87 @@ void SketchMapBase::calculateProjections( const Matrix<double>& targets, Matrix<
 double SketchMapBase::calculateStress( const std::vector<double>& p, std::vector<double>& d ) {
   // Zero derivative and stress accumulators
   for(unsigned i=0; i<p.size(); ++i) d[i]=0.0;
-  double stress=0; std::vector<double> dtmp( p.size() );
-  // Now accumulate total stress on system
-  for(unsigned i=0; i<ftargets.size(); ++i) {
-    if( dtargets[i]<epsilon ) continue ;
-
-    // Calculate distance in low dimensional space
-    double dd=0;
-    for(unsigned j=0; j<p.size(); ++j) { dtmp[j]=p[j]-projections(i,j); dd+=dtmp[j]*dtmp[j]; }
-    dd = sqrt(dd);
-
-    // Now do transformations and calculate differences
-    double df, fd = transformLowDimensionalDistance( dd, df );
-    double ddiff = dd - dtargets[i];
-    double fdiff = fd - ftargets[i];
-
-    // Calculate derivatives
-    double pref = 2.*getWeight(i) / dd ;
-    for(unsigned j=0; j<p.size(); ++j) d[j] += pref*( (1-mixparam)*fdiff*df + mixparam*ddiff )*dtmp[j];
-
-    // Accumulate the total stress
-    stress += getWeight(i)*( (1-mixparam)*fdiff*fdiff + mixparam*ddiff*ddiff );
-  }
-  return stress;
-}
+  const unsigned nt=OpenMP::getNumThreads();
+  derivReduction.resize( nt, d.size() );
+  // The stress of each thread is summed in a fixed order so the result does not depend on the scheduling
+  std::vector<double> tstress( nt, 0.0 );
+
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<double>& myd( derivReduction.getBuffer( OpenMP::getThreadNum() ) );
+    std::vector<double> dtmp( p.size() ); double stress=0;
+    // Now accumulate total stress on system
+    #pragma omp for schedule(static) nowait
+    for(unsigned i=0; i<ftargets.size(); ++i) {
+      if( dtargets[i]<epsilon ) continue ;
 
-double SketchMapBase::calculateFullStress( const std::vector<double>& p, std::vector<double>& d ) {
-  // Zero derivative and stress accumulators
-  for(unsigned i=0; i<p.size(); ++i) d[i]=0.0;
-  double stress=0; std::vector<double> dtmp( nlow );
-
-  for(unsigned i=1; i<distances.nrows(); ++i) {
-    double iweight = pweights[i];
-    for(unsigned j=0; j<i; ++j) {
-      double jweight =  pweights[j];
       // Calculate distance in low dimensional space
       double dd=0;
-      for(unsigned k=0; k<nlow; ++k) { dtmp[k]=p[nlow*i+k] - p[nlow*j+k]; dd+=dtmp[k]*dtmp[k]; }
+      for(unsigned j=0; j<p.size(); ++j) { dtmp[j]=p[j]-projections(i,j); dd+=dtmp[j]*dtmp[j]; }
       dd = sqrt(dd);
 
       // Now do transformations and calculate differences
       double df, fd = transformLowDimensionalDistance( dd, df );
-      double ddiff = dd - distances(i,j);
-      double fdiff = fd - transformed(i,j);;
+      double ddiff = dd - dtargets[i];
+      double fdiff = fd - ftargets[i];
 
       // Calculate derivatives
-      double pref = 2.*iweight*jweight*( (1-mixparam)*fdiff*df + mixparam*ddiff ) / dd;
-      for(unsigned k=0; k<nlow; ++k) {
-        double dterm=pref*dtmp[k]; d[nlow*i+k]+=dterm; d[nlow*j+k]-=dterm;
-      }
+      double pref = 2.*getWeight(i) / dd ;
+      for(unsigned j=0; j<p.size(); ++j) myd[j] += pref*( (1-mixparam)*fdiff*df + mixparam*ddiff )*dtmp[j];
 
       // Accumulate the total stress
-      stress += iweight*jweight*( (1-mixparam)*fdiff*fdiff + mixparam*ddiff*ddiff );
+      stress += getWeight(i)*( (1-mixparam)*fdiff*fdiff + mixparam*ddiff*ddiff );
+    }
+    tstress[OpenMP::getThreadNum()]=stress;
+    derivReduction.reduce( d );
+  }
+  double stress=0;
+  for(unsigned t=0; t<nt; ++t) stress+=tstress[t];
+  return stress;
+}
+
+double SketchMapBase::calculateFullStress( const std::vector<double>& p, std::vector<double>& d ) {
+  // Zero derivative and stress accumulators
+  for(unsigned i=0; i<p.size(); ++i) d[i]=0.0;
+  const unsigned nt=OpenMP::getNumThreads();
+  derivReduction.resize( nt, d.size() );
+  std::vector<double> tstress( nt, 0.0 );
+
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<double>& myd( derivReduction.getBuffer( OpenMP::getThreadNum() ) );
+    std::vector<double> dtmp( nlow ); double stress=0;
+    // Rows are dealt cyclically to the threads so that the triangular loop is balanced
+    #pragma omp for schedule(static,1) nowait
+    for(unsigned i=1; i<distances.nrows(); ++i) {
+      double iweight = pweights[i];
+      for(unsigned j=0; j<i; ++j) {
+        double jweight =  pweights[j];
+        // Calculate distance in low dimensional space
+        double dd=0;
+        for(unsigned k=0; k<nlow; ++k) { dtmp[k]=p[nlow*i+k] - p[nlow*j+k]; dd+=dtmp[k]*dtmp[k]; }
+        dd = sqrt(dd);
+
+        // Now do transformations and calculate differences
+        double df, fd = transformLowDimensionalDistance( dd, df );
+        double ddiff = dd - distances(i,j);
+        double fdiff = fd - transformed(i,j);;
+
+        // Calculate derivatives
+        double pref = 2.*iweight*jweight*( (1-mixparam)*fdiff*df + mixparam*ddiff ) / dd;
+        for(unsigned k=0; k<nlow; ++k) {
+          double dterm=pref*dtmp[k]; myd[nlow*i+k]+=dterm; myd[nlow*j+k]-=dterm;
+        }
+
+        // Accumulate the total stress
+        stress += iweight*jweight*( (1-mixparam)*fdiff*fdiff + mixparam*ddiff*ddiff );
+      }
     }
+    tstress[OpenMP::getThreadNum()]=stress;
+    derivReduction.reduce( d );
   }
+  double stress=0;
+  for(unsigned t=0; t<nt; ++t) stress+=tstress[t];
   stress /= normw; for (unsigned k=0; k < d.size(); ++k) d[k] /= normw;
   return stress;
 }
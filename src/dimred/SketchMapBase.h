@@ -23,6 +23,7 @@
 #define __PLUMED_dimred_SketchMapBase_h
 
 #include "tools/SwitchingFunction.h"
+#include "tools/ThreadReduction.h"
 #include "DimensionalityReductionBase.h"
 
 namespace PLMD {
@@ -42,6 +43,8 @@ private:
   std::vector<double> dtargets, ftargets, pweights;
 /// Stress normalization (sum_ij w_i w_j)
   double normw;
+/// Per-thread buffers for the derivatives of the full stress
+  ThreadReduction<double> derivReduction;
 protected:
 /// This holds the target distances and target transformed distances
   Matrix<double> distances, transformed;
@@ -174,10 +174,12 @@ double SketchMapRead::getDissimilarity( const unsigned& i, const unsigned& j ) {
   plumed_assert( i<myframes.size() && j<myframes.size() );
   if( i!=j ) {
     double dd;
-    getStoredData( i, true ).transferDataToPDB( mypdb );
-    auto myref1=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    getStoredData( j, true ).transferDataToPDB( mypdb );
-    auto myref2=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
+    // A local copy of the PDB is used so that this can be called by several threads at once
+    PDB mypdb2; mypdb2.setArgumentNames( mypdb.getArgumentNames() );
+    getStoredData( i, true ).transferDataToPDB( mypdb2 );
+    auto myref1=metricRegister().create<ReferenceConfiguration>(mtype, mypdb2);
+    getStoredData( j, true ).transferDataToPDB( mypdb2 );
+    auto myref2=metricRegister().create<ReferenceConfiguration>(mtype, mypdb2);
     dd=distance( getPbc(), ActionWithArguments::getArguments(), myref1.get(), myref2.get(), true );
     return dd;
   }
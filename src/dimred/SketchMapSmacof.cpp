@@ -22,6 +22,7 @@
 #include "core/ActionRegister.h"
 #include "SketchMapBase.h"
 #include "SMACOF.h"
+#include "tools/OpenMP.h"
 
 //+PLUMEDOC DIMRED SKETCHMAP_SMACOF
 /*
@@ -82,27 +83,41 @@ void SketchMapSmacof::minimise( Matrix<double>& projections ) {
 }
 
 double SketchMapSmacof::recalculateWeights( const Matrix<double>& projections, Matrix<double>& weights ) {
-  double filt=0, totalWeight=0.;; double dr;
-  for(unsigned i=1; i<weights.nrows(); ++i) {
-    for(unsigned j=0; j<i; ++j) {
-      double ninj=getWeight(i)*getWeight(j); totalWeight += ninj;
-
-      double tempd=0;
-      for(unsigned k=0; k<projections.ncols(); ++k) {
-        double tmp = projections(i,k) - projections(j,k);
-        tempd += tmp*tmp;
+  const unsigned nt=OpenMP::getNumThreads();
+  std::vector<double> myweights( weights.nrows() );
+  for(unsigned i=0; i<myweights.size(); ++i) myweights[i]=getWeight(i);
+  // The partial sums of the threads are added in a fixed order so that the result does not depend on the scheduling
+  std::vector<double> tfilt( nt, 0.0 ), tweight( nt, 0.0 );
+  #pragma omp parallel num_threads(nt)
+  {
+    double myfilt=0, mytotal=0.;
+    // Rows are dealt cyclically to the threads so that the triangular loop is balanced
+    #pragma omp for schedule(static,1) nowait
+    for(unsigned i=1; i<weights.nrows(); ++i) {
+      for(unsigned j=0; j<i; ++j) {
+        double dr;
+        double ninj=myweights[i]*myweights[j]; mytotal += ninj;
+
+        double tempd=0;
+        for(unsigned k=0; k<projections.ncols(); ++k) {
+          double tmp = projections(i,k) - projections(j,k);
+          tempd += tmp*tmp;
+        }
+        double dij=sqrt(tempd);
+
+        double fij = transformLowDimensionalDistance( dij, dr );
+        double filter=transformed(i,j)-fij;
+        double diff=distances(i,j) - dij;
+
+        if( fabs(diff)<regulariser ) weights(i,j)=weights(j,i)=0.0;
+        else weights(i,j)=weights(j,i) = ninj*( (1-mixparam)*( filter*dr )/diff + mixparam );
+        myfilt += ninj*( (1-mixparam)*filter*filter + mixparam*diff*diff );
       }
-      double dij=sqrt(tempd);
-
-      double fij = transformLowDimensionalDistance( dij, dr );
-      double filter=transformed(i,j)-fij;
-      double diff=distances(i,j) - dij;
-
-      if( fabs(diff)<regulariser ) weights(i,j)=weights(j,i)=0.0;
-      else weights(i,j)=weights(j,i) = ninj*( (1-mixparam)*( filter*dr )/diff + mixparam );
-      filt += ninj*( (1-mixparam)*filter*filter + mixparam*diff*diff );
     }
+    tfilt[OpenMP::getThreadNum()]=myfilt; tweight[OpenMP::getThreadNum()]=mytotal;
   }
+  double filt=0, totalWeight=0.;
+  for(unsigned t=0; t<nt; ++t) { filt+=tfilt[t]; totalWeight+=tweight[t]; }
   return filt / totalWeight;
 }
 
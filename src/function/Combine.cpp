@@ -86,6 +86,7 @@ class Combine :
   std::vector<double> powers;
 public:
   explicit Combine(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -173,6 +173,7 @@ class Custom :
   vector<char*> names;
 public:
   explicit Custom(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -29,6 +29,7 @@
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
 #include "tools/Grid.h"
+#include "tools/BinaryHills.h"
 #include <iostream>
 #include <memory>
 
@@ -58,6 +59,9 @@ There are currently no examples for this keyword.
 class FilesHandler {
   vector <string> filenames;
   vector <std::unique_ptr<IFile>>  ifiles;
+  vector <bool> isbinary;
+  std::unique_ptr<BinaryHillsReader> breader;
+  vector <double> record;
   Action *action;
   Log *log;
   bool parallelread;
@@ -67,6 +71,8 @@ public:
   FilesHandler(const vector<string> &filenames, const bool &parallelread,  Action &myaction, Log &mylog);
   bool readBunch(BiasRepresentation *br, int stride);
   bool scanOneHill(BiasRepresentation *br, IFile *ifile );
+  bool scanOneHill(BiasRepresentation *br, BinaryHillsReader *reader );
+  void openFile(unsigned i);
   void getMinMaxBin(vector<Value*> vals, Communicator &cc, vector<double> &vmin, vector<double> &vmax, vector<unsigned> &vbin);
   void getMinMaxBin(vector<Value*> vals, Communicator &cc, vector<double> &vmin, vector<double> &vmax, vector<unsigned> &vbin, vector<double> &histosigma);
 };
@@ -76,11 +82,20 @@ FilesHandler::FilesHandler(const vector<string> &filenames, const bool &parallel
     std::unique_ptr<IFile> ifile(new IFile());
     ifile->link(action);
     plumed_massert((ifile->FileExist(filenames[i])), "the file "+filenames[i]+" does not exist " );
+    isbinary.push_back(BinaryHillsReader::isBinary(ifile->getPath()));
     ifiles.emplace_back(std::move(ifile));
   }
 
 }
 
+void FilesHandler::openFile(unsigned i) {
+  (*log)<<"  opening file "<<filenames[i]<<"\n";
+  ifiles[i]->open(filenames[i]);
+  isopen=true;
+  if(isbinary[i]) breader.reset(new BinaryHillsReader(*ifiles[i]));
+  else breader.reset();
+}
+
 // note that the FileHandler is completely transparent respect to the biasrepresentation
 // no check are made at this level
 bool FilesHandler::readBunch(BiasRepresentation *br, int stride = -1) {
@@ -94,14 +109,11 @@ bool FilesHandler::readBunch(BiasRepresentation *br, int stride = -1) {
     // is the type defined? if not, assume it is a gaussian
     IFile *ff;
     ff=ifiles[beingread].get();
-    if(!isopen) {
-      (*log)<<"  opening file "<<filenames[beingread]<<"\n";
-      ff->open(filenames[beingread]); isopen=true;
-    }
+    if(!isopen) openFile(beingread);
     int n;
     while(true) {
       bool fileisover=true;
-      while(scanOneHill(br,ff)) {
+      while(breader ? scanOneHill(br,breader.get()) : scanOneHill(br,ff)) {
         // here do the dump if needed
         n=br->getNumberOfKernels();
         if(stride>0 && n%stride==0 && n!=0  ) {
@@ -112,14 +124,14 @@ bool FilesHandler::readBunch(BiasRepresentation *br, int stride = -1) {
       }
       if(fileisover) {
         (*log)<<"  closing file "<<filenames[beingread]<<"\n";
+        breader.reset();
         ff->close();
         isopen=false;
         (*log)<<"  now total "<<br->getNumberOfKernels()<<" kernels \n";
         beingread++;
         if(beingread<ifiles.size()) {
-          ff=ifiles[beingread].get(); ff->open(filenames[beingread]);
-          (*log)<<"  opening file "<<filenames[beingread]<<"\n";
-          isopen=true;
+          ff=ifiles[beingread].get();
+          openFile(beingread);
         } else {
           morefiles=false;
           (*log)<<"  final chunk: now with "<<n<<" kernels  \n";
@@ -169,6 +181,13 @@ bool FilesHandler::scanOneHill(BiasRepresentation *br, IFile *ifile ) {
 }
 
 
+bool FilesHandler::scanOneHill(BiasRepresentation *br, BinaryHillsReader *reader ) {
+  if(!reader->readRecord(record)) return false;
+  br->pushKernel(*reader,record);
+  return true;
+}
+
+
 double  mylog( double v1 ) {
   return log(v1);
 }
@@ -76,6 +76,7 @@ class Piecewise :
   std::vector<std::pair<double,double> > points;
 public:
   explicit Piecewise(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -62,6 +62,7 @@ class Sort :
 {
 public:
   explicit Sort(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
@@ -63,6 +63,7 @@ class Stats :
   bool upperd;
 public:
   explicit Stats(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   void calculate();
   static void registerKeywords(Keywords& keys);
 };
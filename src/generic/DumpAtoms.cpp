@@ -140,6 +140,7 @@ class DumpAtoms:
 public:
   explicit DumpAtoms(const ActionOptions&);
   ~DumpAtoms();
+  bool checkIsStateless()const {return true;}
   static void registerKeywords( Keywords& keys );
   void calculate() {}
   void apply() {}
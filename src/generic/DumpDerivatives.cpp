@@ -64,6 +64,7 @@ class DumpDerivatives :
 public:
   void calculate() {}
   explicit DumpDerivatives(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
   static void registerKeywords(Keywords& keys);
   void apply() {}
   void update();
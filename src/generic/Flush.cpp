@@ -60,6 +60,7 @@ class Flush:
   public ActionPilot
 {
 public:
+  bool checkIsStateless()const {return true;}
   explicit Flush(const ActionOptions&ao):
     Action(ao),
     ActionPilot(ao)
@@ -124,6 +124,7 @@ class Group:
 
 public:
   explicit Group(const ActionOptions&ao);
+  bool checkIsStateless()const {return true;}
   ~Group();
   static void registerKeywords( Keywords& keys );
   void calculate() {}
@@ -88,6 +88,7 @@ public:
   void calculate() {}
   void prepare();
   explicit Print(const ActionOptions&);
+  bool checkIsStateless()const {return rotate==0;}
   static void registerKeywords(Keywords& keys);
   void apply() {}
   void update();
@@ -47,6 +47,7 @@ class Time : public ActionWithValue {
 public:
   static void registerKeywords( Keywords& keys );
   explicit Time(const ActionOptions&);
+  bool checkIsStateless()const {return true;}
 // active methods:
   virtual void calculate();
   virtual void apply() {}
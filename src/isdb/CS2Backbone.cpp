@@ -40,6 +40,10 @@
 #include "tools/Pbc.h"
 #include "tools/PDB.h"
 #include "tools/Torsion.h"
+#include "tools/LinkCells.h"
+#include "tools/OpenMP.h"
+#include "tools/ThreadReduction.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -470,6 +474,10 @@ class CS2Backbone : public MetainferenceBase {
   bool             camshift;
   bool             pbc;
   bool             serial;
+  /// link cells used to build the non-bonded neighbour lists
+  LinkCells        linkcells;
+  /// per-thread buffers for the derivatives of the score
+  ThreadReduction<Vector> reduction;
 
   void init_cs(const string &file, const string &k, const PDB &pdb);
   void update_neighb();
@@ -523,7 +531,8 @@ CS2Backbone::CS2Backbone(const ActionOptions&ao):
   max_cs_atoms(0),
   camshift(false),
   pbc(true),
-  serial(false)
+  serial(false),
+  linkcells(comm)
 {
   vector<AtomNumber> used_atoms;
   parseAtomList("ATOMS",used_atoms);
@@ -1279,6 +1288,8 @@ void CS2Backbone::calculate()
       }
       comm.Sum(&all_shifts[0], chemicalshifts.size());
     }
+    // each chemical shift has its own component, so they can be set in parallel
+    #pragma omp parallel for num_threads(nt)
     for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
       Value *comp = chemicalshifts[cs].comp;
       comp->set(all_shifts[cs]);
@@ -1297,29 +1308,28 @@ void CS2Backbone::calculate()
   }
 
   double score = 0.;
+  if(getDoScore()) score = getScore();
 
-  /* Metainference */
-  if(getDoScore()) {
-    score = getScore();
+  /* Metainference or camshift: the derivatives of the shifts are scattered on the atoms */
+  if(nt>1) reduction.resize(nt,getNumberOfAtoms());
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<Vector> & myderivs(nt>1?reduction.getBuffer(OpenMP::getThreadNum()):aa_derivs);
+    #pragma omp for reduction(+:score) nowait
     for(unsigned cs=rank; cs<chemicalshifts.size(); cs+=stride) {
       const unsigned kdx=cs*max_cs_atoms;
-      const double fact = getMetaDer(cs);
-      for(unsigned i=0; i<chemicalshifts[cs].totcsatoms; i++) {
-        aa_derivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
+      double fact;
+      if(getDoScore()) {
+        fact = getMetaDer(cs);
+      } else {
+        score += (all_shifts[cs] - chemicalshifts[cs].exp_cs)*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
+        fact = 2.0*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
       }
-    }
-  }
-
-  /* camshift */
-  if(camshift) {
-    for(unsigned cs=rank; cs<chemicalshifts.size(); cs+=stride) {
-      const unsigned kdx=cs*max_cs_atoms;
-      score += (all_shifts[cs] - chemicalshifts[cs].exp_cs)*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
-      double fact = 2.0*(all_shifts[cs] - chemicalshifts[cs].exp_cs)/camshift_sigma2[chemicalshifts[cs].atm_kind];
       for(unsigned i=0; i<chemicalshifts[cs].totcsatoms; i++) {
-        aa_derivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
+        myderivs[cs_atoms[kdx+i]] += cs_derivs[kdx+i]*fact;
       }
     }
+    if(nt>1) reduction.reduce(aa_derivs);
   }
 
   if(!serial) {
@@ -1352,26 +1362,60 @@ void CS2Backbone::calculate()
 }
 
 void CS2Backbone::update_neighb() {
-  max_cs_atoms=0;
+  const unsigned natoms = getNumberOfAtoms();
+  const vector<Vector> & positions(getPositions());
+  // distances are not periodic, so the cells are built in an orthorhombic box enclosing all the atoms
+  // periodic images can then only add candidates, which are discarded below
+  Vector lower(positions[0]), upper(positions[0]);
+  for(unsigned i=1; i<natoms; i++) for(unsigned k=0; k<3; k++) {
+      lower[k] = std::min(lower[k],positions[i][k]);
+      upper[k] = std::max(upper[k],positions[i][k]);
+    }
+  Tensor box;
+  for(unsigned k=0; k<3; k++) box(k,k) = upper[k]-lower[k]+cutOffNB;
+  Pbc cellpbc;
+  cellpbc.setBox(box);
+  vector<unsigned> cellind(natoms);
+  for(unsigned i=0; i<natoms; i++) cellind[i] = i;
+  linkcells.setCutoff(cutOffNB);
+  linkcells.buildCellLists(positions,cellind,cellpbc);
+
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*2>chemicalshifts.size()) nt=1;
+
+  unsigned max_atoms=0;
   // cycle over chemical shifts
-  for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
-    const unsigned boxsize = getNumberOfAtoms();
-    chemicalshifts[cs].box_nb.clear();
-    chemicalshifts[cs].box_nb.reserve(150);
-    const unsigned res_curr = res_num[chemicalshifts[cs].ipos];
-    for(unsigned bat=0; bat<boxsize; bat++) {
-      const unsigned res_dist = abs(static_cast<int>(res_curr-res_num[bat]));
-      if(res_dist<2) continue;
-      const Vector distance = delta(getPosition(bat),getPosition(chemicalshifts[cs].ipos));
-      const double d2=distance.modulo2();
-      if(d2<cutOffNB2) chemicalshifts[cs].box_nb.push_back(bat);
+  #pragma omp parallel num_threads(nt)
+  {
+    vector<unsigned> cell_list, atoms(natoms+1);
+    #pragma omp for schedule(dynamic) reduction(max:max_atoms)
+    for(unsigned cs=0; cs<chemicalshifts.size(); cs++) {
+      const unsigned ipos = chemicalshifts[cs].ipos;
+      chemicalshifts[cs].box_nb.clear();
+      const unsigned res_curr = res_num[ipos];
+      unsigned natomsper = 1; atoms[0] = ipos;
+      linkcells.retrieveNeighboringAtoms(positions[ipos],cell_list,natomsper,atoms);
+      for(unsigned k=1; k<natomsper; k++) {
+        const unsigned bat = atoms[k];
+        const unsigned res_dist = abs(static_cast<int>(res_curr-res_num[bat]));
+        if(res_dist<2) continue;
+        const Vector distance = delta(positions[bat],positions[ipos]);
+        const double d2=distance.modulo2();
+        if(d2<cutOffNB2) chemicalshifts[cs].box_nb.push_back(bat);
+      }
+      // keep the same order as when looping over all the atoms
+      std::sort(chemicalshifts[cs].box_nb.begin(),chemicalshifts[cs].box_nb.end());
+      chemicalshifts[cs].totcsatoms = chemicalshifts[cs].csatoms + chemicalshifts[cs].box_nb.size();
+      if(chemicalshifts[cs].totcsatoms>max_atoms) max_atoms = chemicalshifts[cs].totcsatoms;
     }
-    chemicalshifts[cs].totcsatoms = chemicalshifts[cs].csatoms + chemicalshifts[cs].box_nb.size();
-    if(chemicalshifts[cs].totcsatoms>max_cs_atoms) max_cs_atoms = chemicalshifts[cs].totcsatoms;
   }
+  max_cs_atoms = max_atoms;
 }
 
 void CS2Backbone::compute_ring_parameters() {
+  unsigned nt=OpenMP::getNumThreads();
+  if(nt*2>ringInfo.size()) nt=1;
+  #pragma omp parallel for num_threads(nt)
   for(unsigned i=0; i<ringInfo.size(); i++) {
     const unsigned size = ringInfo[i].numAtoms;
     if(size==6) {
@@ -1381,7 +1425,7 @@ void CS2Backbone::compute_ring_parameters() {
       ringInfo[i].g[3] = delta(getPosition(ringInfo[i].atom[1]),getPosition(ringInfo[i].atom[5]));
       ringInfo[i].g[4] = delta(getPosition(ringInfo[i].atom[2]),getPosition(ringInfo[i].atom[0]));
       ringInfo[i].g[5] = delta(getPosition(ringInfo[i].atom[3]),getPosition(ringInfo[i].atom[1]));
-      vector<Vector> a(6);
+      Vector a[6];
       a[0] = getPosition(ringInfo[i].atom[0]);
       // ring center
       Vector midP = a[0];
@@ -1398,7 +1442,7 @@ void CS2Backbone::compute_ring_parameters() {
       ringInfo[i].g[0] = delta(getPosition(ringInfo[i].atom[3]),getPosition(ringInfo[i].atom[2]));
       ringInfo[i].g[1] = delta(getPosition(ringInfo[i].atom[0]),getPosition(ringInfo[i].atom[3]));
       ringInfo[i].g[2] = delta(getPosition(ringInfo[i].atom[2]),getPosition(ringInfo[i].atom[0]));
-      vector<Vector> a(size);
+      Vector a[5];
       for(unsigned j=0; j<size; j++) {
         a[j] = getPosition(ringInfo[i].atom[j]);
       }
@@ -26,11 +26,15 @@
 #include "core/SetupMolInfo.h"
 #include "core/ActionSet.h"
 #include "tools/File.h"
+#include "tools/LinkCells.h"
+#include "tools/Communicator.h"
+#include "tools/Pbc.h"
 
 #include <string>
 #include <cmath>
 #include <map>
 #include <numeric>
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 
@@ -152,6 +156,10 @@ private:
   unsigned nl_stride_;
   bool first_time_, no_aver_;
   vector < unsigned > nl_;
+// squared distance beyond which a data GMM component cannot be in the neighbor list
+  vector<double> nl_dist2_;
+// link cells of the data GMM components, used to update the neighbor list
+  LinkCells linkcells_;
 // parallel stuff
   unsigned size_;
   unsigned rank_;
@@ -177,6 +185,8 @@ private:
   void get_auxiliary_stuff();
 // get cutoff in overlap
   void get_cutoff_ov();
+// get cutoff in distance for each data GMM component
+  void get_cutoff_dist();
 // get fact_md and inv_cov_md
   double get_prefactor_inverse (const VectorGeneric<6> &GMM_cov_0, const VectorGeneric<6> &GMM_cov_1,
                                 double &GMM_w_0, double &GMM_w_1,
@@ -224,6 +234,7 @@ EMMI::EMMI(const ActionOptions&ao):
   sqrt2_pi_(0.797884560802865),
   nl_cutoff_(-1.0), nl_stride_(0),
   first_time_(true), no_aver_(false),
+  linkcells_(comm),
   analysis_(false), nframe_(0.0), pbc_(true)
 {
 
@@ -318,6 +329,9 @@ EMMI::EMMI(const ActionOptions&ao):
   // get cutoff for overlap calculation - avoid millions of exp calculations
   get_cutoff_ov();
 
+  // and the corresponding distances, used to update the neighbor list with link cells
+  get_cutoff_dist();
+
   // and prepare temporary vectors
   ovmd_.resize(GMM_d_w_.size());
   err_f_.resize(GMM_d_w_.size());
@@ -595,6 +609,28 @@ void EMMI::get_cutoff_ov()
   ov_cut_ = -2.0 * std::log(ov_cut_);
 }
 
+// the overlap is computed only if md^T inv_cov_md md <= ov_cut_,
+// which requires |md|^2 <= ov_cut_ times the largest eigenvalue of the sum
+// of the covariances. The eigenvalue is bound using the Gershgorin circles.
+void EMMI::get_cutoff_dist()
+{
+  // largest variance of the model GMM components
+  double s2_max = 0.0;
+  for(unsigned i=0; i<s_map_.size(); ++i) {
+    double s = sqrt ( 0.5 * s_map_[i] ) / pi * 0.1;
+    s2_max = std::max(s2_max, s*s);
+  }
+  nl_dist2_.resize(GMM_d_w_.size());
+  for(unsigned i=0; i<GMM_d_w_.size(); ++i) {
+    const VectorGeneric<6> & cov = GMM_d_cov_[i];
+    double l_max = std::abs(cov[0])+std::abs(cov[1])+std::abs(cov[2]);
+    l_max = std::max(l_max, std::abs(cov[1])+std::abs(cov[3])+std::abs(cov[4]));
+    l_max = std::max(l_max, std::abs(cov[2])+std::abs(cov[4])+std::abs(cov[5]));
+    // small margin to be safe against rounding
+    nl_dist2_[i] = 1.0001 * ov_cut_ * ( l_max + s2_max );
+  }
+}
+
 // version with derivatives
 double EMMI::get_overlap(const Vector &m_m, const Vector &d_m, double &fact_md,
                          const VectorGeneric<6> &inv_cov_md, Vector &ov_der)
@@ -649,42 +685,88 @@ void EMMI::update_neighbor_list()
   vector < unsigned > nl_l;
   // clear old neighbor list
   nl_.clear();
-  // cycle on all overlaps (in parallel)
-  unsigned nover = GMM_d_w_size * GMM_m_w_size;
-  for(unsigned k=rank_; k<nover; k=k+size_) {
-    // get indexes
-    unsigned i = k / GMM_m_w_size;
-    unsigned j = k % GMM_m_w_size;
-    // get atom type
-    unsigned jtype = GMM_m_type_[j];
-    // get index in auxiliary lists
-    unsigned kaux = jtype * GMM_d_w_size + i;
-    // get prefactor and multiply by weights
-    double pre_fact = fact_md_[kaux] * GMM_d_w_[i] * GMM_m_w_[j];
-    // calculate overlap
-    double ov = get_overlap(GMM_d_m_[i], getPosition(j), pre_fact, inv_cov_md_[kaux]);
-    // fill the neighbor list
-    if(ov >= ovdd_cut_[i]) nl_l.push_back(k);
+  // data GMM components are sorted in link cells, so that for each atom
+  // only the components within the cutoff distance are considered
+  double dist2_max = 0.0;
+  for(unsigned i=0; i<nl_dist2_.size(); ++i) dist2_max = std::max(dist2_max, nl_dist2_[i]);
+  if(dist2_max>0.0 && GMM_d_w_size>0) {
+    const double dist_max = sqrt(dist2_max);
+    // without pbc the cells are built in an orthorhombic box enclosing all the components
+    Pbc cellpbc;
+    if(pbc_ && getPbc().isSet()) {
+      cellpbc.setBox(getBox());
+    } else {
+      Vector lower(GMM_d_m_[0]), upper(GMM_d_m_[0]);
+      for(unsigned i=1; i<GMM_d_w_size; ++i) for(unsigned l=0; l<3; ++l) {
+          lower[l] = std::min(lower[l], GMM_d_m_[i][l]);
+          upper[l] = std::max(upper[l], GMM_d_m_[i][l]);
+        }
+      Tensor box;
+      for(unsigned l=0; l<3; ++l) box(l,l) = upper[l]-lower[l]+dist_max;
+      cellpbc.setBox(box);
+    }
+    vector<unsigned> indices(GMM_d_w_size);
+    for(unsigned i=0; i<GMM_d_w_size; ++i) indices[i] = i;
+    linkcells_.setCutoff(dist_max);
+    linkcells_.buildCellLists(GMM_d_m_, indices, cellpbc);
+    // cycle on all atoms (in parallel)
+    vector<unsigned> cell_list, comps(GMM_d_w_size+1);
+    for(unsigned j=rank_; j<GMM_m_w_size; j=j+size_) {
+      const Vector pos = getPosition(j);
+      // first element is a placeholder required by LinkCells
+      unsigned ncomps = 1; comps[0] = GMM_d_w_size;
+      linkcells_.retrieveNeighboringAtoms(pos, cell_list, ncomps, comps);
+      // get atom type
+      unsigned jtype = GMM_m_type_[j];
+      for(unsigned l=1; l<ncomps; ++l) {
+        unsigned i = comps[l];
+        // these are added below
+        if(ovdd_cut_[i]<=0.0) continue;
+        Vector md;
+        if(pbc_) md = pbcDistance(GMM_d_m_[i], pos);
+        else     md = delta(GMM_d_m_[i], pos);
+        if(md.modulo2() > nl_dist2_[i]) continue;
+        // get index in auxiliary lists
+        unsigned kaux = jtype * GMM_d_w_size + i;
+        // get prefactor and multiply by weights
+        double pre_fact = fact_md_[kaux] * GMM_d_w_[i] * GMM_m_w_[j];
+        // calculate overlap
+        double ov = get_overlap(GMM_d_m_[i], pos, pre_fact, inv_cov_md_[kaux]);
+        // fill the neighbor list
+        if(ov >= ovdd_cut_[i]) nl_l.push_back(i * GMM_m_w_size + j);
+      }
+    }
+  }
+  // components with a vanishing overlap cutoff are neighbors of all the atoms
+  for(unsigned i=0; i<GMM_d_w_size; ++i) {
+    if(ovdd_cut_[i]>0.0) continue;
+    for(unsigned j=rank_; j<GMM_m_w_size; j=j+size_) nl_l.push_back(i * GMM_m_w_size + j);
   }
-  // find total dimension of neighborlist
-  vector <int> recvcounts(size_, 0);
-  recvcounts[rank_] = nl_l.size();
-  comm.Sum(&recvcounts[0], size_);
-  int tot_size = accumulate(recvcounts.begin(), recvcounts.end(), 0);
-  // resize neighbor stuff
-  nl_.resize(tot_size);
-  // calculate vector of displacement
-  vector<int> disp(size_);
-  disp[0] = 0;
-  int rank_size = 0;
-  for(unsigned i=0; i<size_-1; ++i) {
-    rank_size += recvcounts[i];
-    disp[i+1] = rank_size;
+  if(size_>1) {
+    // find total dimension of neighborlist
+    vector <int> recvcounts(size_, 0);
+    recvcounts[rank_] = nl_l.size();
+    comm.Sum(&recvcounts[0], size_);
+    int tot_size = accumulate(recvcounts.begin(), recvcounts.end(), 0);
+    // resize neighbor stuff
+    nl_.resize(tot_size);
+    // calculate vector of displacement
+    vector<int> disp(size_);
+    disp[0] = 0;
+    int rank_size = 0;
+    for(unsigned i=0; i<size_-1; ++i) {
+      rank_size += recvcounts[i];
+      disp[i+1] = rank_size;
+    }
+    // Allgather neighbor list
+    comm.Allgatherv(&nl_l[0], recvcounts[rank_], &nl_[0], &recvcounts[0], &disp[0]);
+  } else {
+    nl_.swap(nl_l);
   }
-  // Allgather neighbor list
-  comm.Allgatherv(&nl_l[0], recvcounts[rank_], &nl_[0], &recvcounts[0], &disp[0]);
+  // keep the same order as a loop over all the pairs
+  std::sort(nl_.begin(), nl_.end());
   // now resize derivatives
-  ovmd_der_.resize(tot_size);
+  ovmd_der_.resize(nl_.size());
 }
 
 void EMMI::prepare()
@@ -73,6 +73,12 @@ An automatic choice is made for which q bessel are used and for which the calcul
 all q values to be calculated using Bessel function this can be done using FORCE_BESSEL.
 Irrespectively of the method employed, \ref METAINFERENCE can be activated using DOSCORE and the other relevant keywords.
 
+With Debye on CPU the pair distances are computed on the fly for blocks of atoms, so that memory does not grow with the
+square of the number of atoms. For very large systems, where exact intensities are not required, DEBYE_BIN can be used
+to approximate the Debye equation by binning the pair distances with the given spacing: \f$\sin(qr)/(qr)\f$ is tabulated
+at the bin edges and linearly interpolated, which is equivalent to computing the intensities from a histogram of the
+distances where each pair is shared between the two closest bins. The derivatives are those of the approximated intensities.
+
 \par Examples
 in the following example the saxs intensities for a martini model are calculated. structure factors
 are obtained from the pdb file indicated in the MOLINFO.
@@ -128,9 +134,12 @@ private:
 #endif
   vector<double>           avals;
   vector<double>           bvals;
+  double                   debye_bin;
+  vector<vector<double> >  debye_table;
 
   void calculate_gpu(vector<Vector> &deriv);
   void calculate_cpu(vector<Vector> &deriv);
+  void update_debye_table(const double maxdist);
   void getMartiniSFparam(const vector<AtomNumber> &atoms, vector<vector<long double> > &parameter);
   void calculateASF(const vector<AtomNumber> &atoms, vector<vector<long double> > &FF_tmp, const double rho);
   void bessel_calculate(vector<Vector> &deriv, vector<double> &sum, vector<Vector2d> &qRnm, const vector<double> &r_polar,
@@ -158,6 +167,7 @@ void SAXS::registerKeywords(Keywords& keys) {
   keys.addFlag("SERIAL",false,"Perform the calculation in serial - for debug purpose");
   keys.addFlag("BESSEL",false,"Perform the calculation using the adaptive spherical harmonic approximation");
   keys.addFlag("FORCE_BESSEL",false,"Perform the calculation using the adaptive spherical harmonic approximation, without adaptive algorithm, usefull for debug only");
+  keys.add("optional","DEBYE_BIN","Approximate the Debye equation by binning the pair distances with this spacing (in nm)");
   keys.add("compulsory","DEVICEID","0","Identifier of the GPU to be used");
   keys.addFlag("GPU",false,"calculate SAXS using ARRAYFIRE on an accellerator device");
   keys.addFlag("ATOMISTIC",false,"calculate SAXS for an atomistic model");
@@ -180,7 +190,8 @@ SAXS::SAXS(const ActionOptions&ao):
   bessel(false),
   force_bessel(false),
   gpu(false),
-  deviceid(0)
+  deviceid(0),
+  debye_bin(0.)
 {
   vector<AtomNumber> atoms;
   parseAtomList("ATOMS",atoms);
@@ -215,6 +226,10 @@ SAXS::SAXS(const ActionOptions&ao):
 
   if(bessel&&gpu) error("You CANNOT use BESSEL on GPU!\n");
 
+  parse("DEBYE_BIN",debye_bin);
+  if(debye_bin<0.) error("DEBYE_BIN should be positive");
+  if(debye_bin>0.&&gpu) error("You CANNOT use DEBYE_BIN on GPU!\n");
+
   double scexp = 0;
   parse("SCALEINT",scexp);
   if(scexp==0) scexp=1.0;
@@ -313,6 +328,7 @@ SAXS::SAXS(const ActionOptions&ao):
 
   if(pbc)      log.printf("  using periodic boundary conditions\n");
   else         log.printf("  without periodic boundary conditions\n");
+  if(debye_bin>0.) log.printf("  Debye equation approximated binning distances every %lf nm\n",debye_bin);
   for(unsigned i=0; i<numq; i++) {
     if(q_list[i]==0.) error("it is not possible to set q=0\n");
     log.printf("  my q: %lf \n",q_list[i]);
@@ -485,8 +501,6 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
   }
 
   vector<double> sum(numq,0);
-  vector<Vector> c_dist(size*size);
-  vector<double> m_dist(size*size);
 
   vector<double> r_polar;
   vector<Vector2d> qRnm;
@@ -505,35 +519,88 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
   }
 
   if(direct) {
-    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
-    for (unsigned i=rank; i<size-1; i+=stride) {
-      const Vector posi=getPosition(i);
-      for (unsigned j=i+1; j<size ; j++) {
-        c_dist[i*size+j] = delta(posi,getPosition(j));
-        m_dist[i*size+j] = c_dist[i*size+j].modulo();
+    if(debye_bin>0.) {
+      // the largest distance is bound by the diagonal of the box containing all the atoms
+      Vector min=getPosition(0), max=getPosition(0);
+      for(unsigned i=1; i<size; i++) {
+        const Vector posi=getPosition(i);
+        for(unsigned l=0; l<3; l++) {
+          if(posi[l]<min[l]) min[l]=posi[l];
+          if(posi[l]>max[l]) max[l]=posi[l];
+        }
       }
+      update_debye_table(delta(min,max).modulo());
     }
 
-    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
-    for (unsigned k=(algorithm+1); k<numq; k++) {
-      const unsigned kdx=k*size;
-      for (unsigned i=rank; i<size-1; i+=stride) {
-        const double FF=2.*FF_value[k][i];
-        Vector dsum;
+    // distances are computed on the fly for blocks of rows, so that memory does not scale as size^2;
+    // within each block the pairs are visited in the same order as a full loop over all the pairs
+    const unsigned pairs_per_block=65536;
+    vector<unsigned> block_rows, block_start;
+    vector<Vector> c_dist;
+    vector<double> m_dist;
+    unsigned first=rank;
+    while(first+1<size) {
+      block_rows.clear();
+      block_start.clear();
+      unsigned npairs=0;
+      unsigned last=first;
+      for(; last+1<size && npairs<pairs_per_block; last+=stride) {
+        block_rows.push_back(last);
+        block_start.push_back(npairs);
+        npairs+=size-1-last;
+      }
+      first=last;
+      c_dist.resize(npairs);
+      m_dist.resize(npairs);
+
+      #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+      for (unsigned r=0; r<block_rows.size(); r++) {
+        const unsigned i=block_rows[r];
+        const Vector posi=getPosition(i);
+        Vector* c=&c_dist[block_start[r]];
+        double* m=&m_dist[block_start[r]];
         for (unsigned j=i+1; j<size ; j++) {
-          const Vector c_distances = c_dist[i*size+j];
-          const double m_distances = m_dist[i*size+j];
-          const double qdist       = q_list[k]*m_distances;
-          const double FFF = FF*FF_value[k][j];
-          const double tsq = FFF*sin(qdist)/qdist;
-          const double tcq = FFF*cos(qdist);
-          const double tmp = (tcq-tsq)/(m_distances*m_distances);
-          const Vector dd  = c_distances*tmp;
-          dsum         += dd;
-          deriv[kdx+j] += dd;
-          sum[k]       += tsq;
+          c[j-i-1] = delta(posi,getPosition(j));
+          m[j-i-1] = c[j-i-1].modulo();
+        }
+      }
+
+      #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+      for (unsigned k=(algorithm+1); k<numq; k++) {
+        const unsigned kdx=k*size;
+        const double* table=(debye_bin>0.?&debye_table[k][0]:NULL);
+        const double inv_bin=(debye_bin>0.?1./debye_bin:0.);
+        for (unsigned r=0; r<block_rows.size(); r++) {
+          const unsigned i=block_rows[r];
+          const Vector* c=&c_dist[block_start[r]];
+          const double* m=&m_dist[block_start[r]];
+          const double FF=2.*FF_value[k][i];
+          Vector dsum;
+          for (unsigned j=i+1; j<size ; j++) {
+            const Vector c_distances = c[j-i-1];
+            const double m_distances = m[j-i-1];
+            const double FFF = FF*FF_value[k][j];
+            double tsq, tmp;
+            if(table) {
+              // linear interpolation of sin(qr)/(qr) between the edges of the bin
+              const double x = m_distances*inv_bin;
+              const unsigned bin = static_cast<unsigned>(x);
+              const double w = x-bin;
+              tsq = FFF*((1.-w)*table[bin]+w*table[bin+1]);
+              tmp = FFF*(table[bin+1]-table[bin])*inv_bin/m_distances;
+            } else {
+              const double qdist = q_list[k]*m_distances;
+              tsq = FFF*sin(qdist)/qdist;
+              const double tcq = FFF*cos(qdist);
+              tmp = (tcq-tsq)/(m_distances*m_distances);
+            }
+            const Vector dd  = c_distances*tmp;
+            dsum         += dd;
+            deriv[kdx+j] += dd;
+            sum[k]       += tsq;
+          }
+          deriv[kdx+i] -= dsum;
         }
-        deriv[kdx+i] -= dsum;
       }
     }
   }
@@ -566,6 +633,23 @@ void SAXS::calculate_cpu(vector<Vector> &deriv)
   }
 }
 
+void SAXS::update_debye_table(const double maxdist)
+{
+  if(q_list.empty()) return;
+  const unsigned nbins=static_cast<unsigned>(maxdist/debye_bin)+2;
+  if(debye_table.size()==q_list.size() && debye_table[0].size()>=nbins) return;
+  // some margin, so that the table is not rebuilt at every step
+  const unsigned nalloc=nbins+nbins/5;
+  debye_table.assign(q_list.size(),vector<double>(nalloc));
+  for(unsigned k=0; k<q_list.size(); k++) {
+    debye_table[k][0]=1.;
+    for(unsigned b=1; b<nalloc; b++) {
+      const double qdist=q_list[k]*b*debye_bin;
+      debye_table[k][b]=sin(qdist)/qdist;
+    }
+  }
+}
+
 void SAXS::calculate()
 {
   if(pbc) makeWhole();
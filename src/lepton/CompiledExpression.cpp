@@ -67,6 +67,8 @@
 #ifdef __PLUMED_HAS_ASMJIT
     #include "asmjit/asmjit.h"
 #endif
+#include <algorithm>
+#include <cmath>
 #include <utility>
 
 namespace PLMD {
@@ -235,6 +237,183 @@ double CompiledExpression::evaluate() const {
 #endif
 }
 
+// Number of points evaluated together by the batch interpreter.
+
+static const int batchSize = 64;
+
+void CompiledExpression::evaluate(const map<string, const double*>& inputs, double* result, int n) const {
+    // The last block is used as scratch space by evaluateBatch().
+    
+    batchWorkspace.resize((workspace.size()+1)*batchSize);
+    
+    // Find where the values of the variables should be taken from.
+    
+    vector<pair<int, const double*> > arrays;
+    vector<pair<int, double> > scalars;
+    for (map<string, int>::const_iterator iter = variableIndices.begin(); iter != variableIndices.end(); ++iter) {
+        map<string, const double*>::const_iterator input = inputs.find(iter->first);
+        if (input != inputs.end())
+            arrays.push_back(make_pair(iter->second*batchSize, input->second));
+        else {
+            map<string, double*>::const_iterator pointer = variablePointers.find(iter->first);
+            scalars.push_back(make_pair(iter->second*batchSize, pointer != variablePointers.end() ? *pointer->second : workspace[iter->second]));
+        }
+    }
+    const int resultIndex = ((int) workspace.size()-1)*batchSize;
+    for (int start = 0; start < n; start += batchSize) {
+        const int m = std::min(batchSize, n-start);
+        for (int i = 0; i < (int) arrays.size(); i++)
+            std::copy(arrays[i].second+start, arrays[i].second+start+m, &batchWorkspace[arrays[i].first]);
+        for (int i = 0; i < (int) scalars.size(); i++)
+            std::fill(&batchWorkspace[scalars[i].first], &batchWorkspace[scalars[i].first]+m, scalars[i].second);
+        evaluateBatch(m);
+        std::copy(&batchWorkspace[resultIndex], &batchWorkspace[resultIndex]+m, result+start);
+    }
+}
+
+void CompiledExpression::evaluateBatch(int n) const {
+    // Each temporary occupies batchSize consecutive elements of batchWorkspace.  The most common operations
+    // are applied to whole arrays, so that the loops can be vectorized by the compiler.  The others are
+    // evaluated point by point.
+    
+    double* w = &batchWorkspace[0];
+    for (int step = 0; step < (int) operation.size(); step++) {
+        const vector<int>& args = arguments[step];
+        const Operation& op = *operation[step];
+        const int numArgs = op.getNumArguments();
+        double* out = w+target[step]*batchSize;
+        const double* a = w+args[0]*batchSize;
+        const double* b = (numArgs > 1 ? w+(args.size() == 1 ? args[0]+1 : args[1])*batchSize : NULL);
+        switch (op.getId()) {
+            case Operation::CONSTANT: {
+                const double value = dynamic_cast<const Operation::Constant&>(op).getValue();
+                for (int i = 0; i < n; i++)
+                    out[i] = value;
+                break;
+            }
+            case Operation::ADD:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]+b[i];
+                break;
+            case Operation::SUBTRACT:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]-b[i];
+                break;
+            case Operation::MULTIPLY:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]*b[i];
+                break;
+            case Operation::DIVIDE:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]/b[i];
+                break;
+            case Operation::POWER:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::pow(a[i], b[i]);
+                break;
+            case Operation::NEGATE:
+                for (int i = 0; i < n; i++)
+                    out[i] = -a[i];
+                break;
+            case Operation::SQRT:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::sqrt(a[i]);
+                break;
+            case Operation::EXP:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::exp(a[i]);
+                break;
+            case Operation::LOG:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::log(a[i]);
+                break;
+            case Operation::SIN:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::sin(a[i]);
+                break;
+            case Operation::COS:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::cos(a[i]);
+                break;
+            case Operation::TANH:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::tanh(a[i]);
+                break;
+            case Operation::STEP:
+                for (int i = 0; i < n; i++)
+                    out[i] = (a[i] >= 0.0 ? 1.0 : 0.0);
+                break;
+            case Operation::SQUARE:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]*a[i];
+                break;
+            case Operation::CUBE:
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]*a[i]*a[i];
+                break;
+            case Operation::RECIPROCAL:
+                for (int i = 0; i < n; i++)
+                    out[i] = 1.0/a[i];
+                break;
+            case Operation::ADD_CONSTANT: {
+                const double value = dynamic_cast<const Operation::AddConstant&>(op).getValue();
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]+value;
+                break;
+            }
+            case Operation::MULTIPLY_CONSTANT: {
+                const double value = dynamic_cast<const Operation::MultiplyConstant&>(op).getValue();
+                for (int i = 0; i < n; i++)
+                    out[i] = a[i]*value;
+                break;
+            }
+            case Operation::POWER_CONSTANT: {
+                const double value = dynamic_cast<const Operation::PowerConstant&>(op).getValue();
+                int exponent = (int) value;
+                if (exponent == value) {
+                    // Same sequence of multiplications as Operation::PowerConstant, applied to the whole array.
+                    
+                    double* base = w+workspace.size()*batchSize;
+                    double* res = out;
+                    if (exponent < 0) {
+                        exponent = -exponent;
+                        for (int i = 0; i < n; i++)
+                            base[i] = 1.0/a[i];
+                    }
+                    else
+                        std::copy(a, a+n, base);
+                    for (int i = 0; i < n; i++)
+                        res[i] = 1.0;
+                    while (exponent != 0) {
+                        if ((exponent&1) == 1)
+                            for (int i = 0; i < n; i++)
+                                res[i] *= base[i];
+                        for (int i = 0; i < n; i++)
+                            base[i] *= base[i];
+                        exponent = exponent>>1;
+                    }
+                }
+                else
+                    for (int i = 0; i < n; i++)
+                        out[i] = std::pow(a[i], value);
+                break;
+            }
+            case Operation::ABS:
+                for (int i = 0; i < n; i++)
+                    out[i] = std::abs(a[i]);
+                break;
+            default: {
+                vector<double> values(std::max(numArgs, 1));
+                for (int i = 0; i < n; i++) {
+                    for (int j = 0; j < numArgs; j++)
+                        values[j] = w[(args.size() == 1 ? args[0]+j : args[j])*batchSize+i];
+                    out[i] = op.evaluate(&values[0], dummyVariables);
+                }
+            }
+        }
+    }
+}
+
 #ifdef __PLUMED_HAS_ASMJIT
 static double evaluateOperation(Operation* op, double* args) {
     static map<string, double> dummyVariables;
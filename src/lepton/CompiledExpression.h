@@ -135,6 +135,12 @@ public:
      * Evaluate the expression.  The values of all variables should have been set before calling this.
      */
     double evaluate() const;
+    /**
+     * Evaluate the expression for a batch of n points.  For each variable in inputs, the corresponding
+     * pointer should point to an array holding its n values.  Variables that are not in inputs take the
+     * same value that would be used by evaluate().  The n results are stored in result.
+     */
+    void evaluate(const std::map<std::string, const double*>& inputs, double* result, int n) const;
 private:
     friend class ParsedExpression;
     CompiledExpression(const ParsedExpression& expression);
@@ -149,6 +155,8 @@ private:
     std::set<std::string> variableNames;
     mutable std::vector<double> workspace;
     mutable std::vector<double> argValues;
+    mutable std::vector<double> batchWorkspace;
+    void evaluateBatch(int n) const;
     std::map<std::string, double> dummyVariables;
     void* jitCode;
     void generateJitCode();
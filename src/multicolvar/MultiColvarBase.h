@@ -148,6 +148,8 @@ protected:
 public:
   explicit MultiColvarBase(const ActionOptions&);
   ~MultiColvarBase() {}
+/// Link cells and task lists are rebuilt at every step, so multicolvars only depend on the current frame
+  bool checkIsStateless()const {return true;}
   static void registerKeywords( Keywords& keys );
 /// Turn on the derivatives
   void turnOnDerivatives();
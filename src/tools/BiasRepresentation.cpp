@@ -26,6 +26,7 @@
 #include "KernelFunctions.h"
 #include "File.h"
 #include "Grid.h"
+#include "BinaryHills.h"
 
 
 namespace PLMD {
@@ -145,7 +146,6 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
     ifile->scanField("biasf",dummy);
     Tools::convert(dummy,dummyd);
   } else {dummyd=1.0;}
-  biasf.push_back(dummyd);
   // the domain does not pertain to the kernel but to the values here defined
   string	mins,maxs,minv,maxv,mini,maxi; mins="min_"; maxs="max_";
   for(int i=0 ; i<ndim; i++) {
@@ -158,6 +158,31 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
       plumed_massert(maxi==maxv,"the input periodicity in hills and in value definition does not match"  );
     }
   }
+  addKernel(std::move(kk),dummyd);
+}
+void BiasRepresentation::pushKernel( const BinaryHillsReader& reader, const std::vector<double>& record ) {
+  std::unique_ptr<KernelFunctions> kk;
+  if(histosigma.size()==0) {
+    kk=KernelFunctions::read(reader,record,true,names);
+  } else {
+    vector<double> cc( names.size() );
+    for(unsigned i=0; i<names.size(); ++i) cc[i]=record[reader.getFieldIndex(names[i])];
+    kk.reset( new KernelFunctions(cc,histosigma,"gaussian","DIAGONAL",1.0) );
+  }
+  double bf=1.0;
+  if(reader.fieldExist("biasf")) bf=record[reader.getFieldIndex("biasf")];
+  for(int i=0 ; i<ndim; i++) {
+    if(values[i]->isPeriodic()) {
+      string mini,maxi;
+      values[i]->getDomain(mini,maxi);
+      plumed_massert(reader.constantExist("min_"+names[i]) && mini==reader.getConstant("min_"+names[i]),"the input periodicity in hills and in value definition does not match"  );
+      plumed_massert(reader.constantExist("max_"+names[i]) && maxi==reader.getConstant("max_"+names[i]),"the input periodicity in hills and in value definition does not match"  );
+    }
+  }
+  addKernel(std::move(kk),bf);
+}
+void BiasRepresentation::addKernel( std::unique_ptr<KernelFunctions> kk, double bf ) {
+  biasf.push_back(bf);
   // if grid is defined then it should be added on the grid
   //cerr<<"now with "<<hills.size()<<endl;
   if(hasgrid) {
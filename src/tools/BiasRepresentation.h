@@ -31,6 +31,7 @@ namespace PLMD {
 class Value;
 class Grid;
 class IFile;
+class BinaryHillsReader;
 class KernelFunctions;
 class Communicator;
 
@@ -61,6 +62,8 @@ public:
   void 		addGrid(const std::vector<std::string> & gmin, const std::vector<std::string> & gmax, const std::vector<unsigned> & nbin );
   /// push a kernel on the representation (includes widths and height)
   void 		pushKernel( IFile * ff);
+  /// push a kernel read from a record of a binary hills file
+  void 		pushKernel( const BinaryHillsReader& reader, const std::vector<double>& record );
   /// set the flag that rescales the free energy to the bias
   void 		setRescaledToBias(bool rescaled);
   /// check if the representation is rescaled to the bias
@@ -86,6 +89,8 @@ public:
   /// clear the representation (grid included)
   void clear();
 private:
+  /// add a kernel with its bias factor to the representation
+  void addKernel( std::unique_ptr<KernelFunctions> kk, double bf );
   int ndim;
   bool hasgrid;
   bool rescaledToBias;
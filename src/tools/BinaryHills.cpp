@@ -0,0 +1,158 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "BinaryHills.h"
+#include "IFile.h"
+#include "OFile.h"
+#include "Tools.h"
+#include "Exception.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+namespace PLMD {
+
+/// First word of the header of binary hills files
+static const char* binaryHillsMagic="#! BINARY_HILLS";
+
+/// Version of the binary format
+static const int binaryHillsVersion=1;
+
+static std::string endianness() {
+  const std::uint16_t one=1;
+  return (*reinterpret_cast<const unsigned char*>(&one)==1 ? "little" : "big");
+}
+
+BinaryHillsReader::BinaryHillsReader(IFile&ifile):
+  ifile(ifile),
+  npending(0),
+  headerDone(false),
+  headerSize(0),
+  nrecords(0)
+{
+}
+
+bool BinaryHillsReader::isBinary(const std::string&path) {
+  if(Tools::extension(path)=="gz") return false;
+  FILE* fp=std::fopen(path.c_str(),"r");
+  if(!fp) return false;
+  const size_t n=std::strlen(binaryHillsMagic);
+  std::vector<char> buffer(n);
+  bool ret=(std::fread(buffer.data(),1,n,fp)==n && std::memcmp(buffer.data(),binaryHillsMagic,n)==0);
+  std::fclose(fp);
+  return ret;
+}
+
+bool BinaryHillsReader::fillPending(size_t n) {
+  if(pending.size()<n) pending.resize(n);
+  if(npending<n) npending+=ifile.readBytes(pending.data()+npending,n-npending);
+  if(npending<n) {
+// data might be appended later by another process
+    ifile.reset(false);
+    return false;
+  }
+  return true;
+}
+
+void BinaryHillsReader::parseHeaderLine(const std::string&line) {
+  std::vector<std::string> words=Tools::getWords(line);
+  if(headerSize==0) {
+    int version=0;
+    if(words.size()!=4 || words[0]+" "+words[1]!=binaryHillsMagic || !Tools::convert(words[2],version))
+      plumed_merror("file "+ifile.getPath()+" is not a binary hills file");
+    if(version!=binaryHillsVersion) plumed_merror("file "+ifile.getPath()+" has an unsupported binary hills version "+words[2]);
+    if(words[3]!=endianness()) plumed_merror("file "+ifile.getPath()+" was written on a machine with different endianness");
+  } else if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
+    fields.assign(words.begin()+2,words.end());
+    fieldIndex.clear();
+    for(unsigned i=0; i<fields.size(); i++) fieldIndex[fields[i]]=i;
+  } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
+    constants.push_back(std::pair<std::string,std::string>(words[2],words[3]));
+  } else if(words.size()==2 && words[0]=="#!" && words[1]=="END") {
+    if(fields.empty()) plumed_merror("file "+ifile.getPath()+": missing FIELDS in binary hills header");
+    headerDone=true;
+  } else plumed_merror("file "+ifile.getPath()+": cannot parse binary hills header line "+line);
+}
+
+bool BinaryHillsReader::readHeader() {
+  while(!headerDone) {
+// the header is short, so it is read one byte at a time
+    if(!fillPending(npending+1)) return false;
+    if(pending[npending-1]!='\n') continue;
+    std::string line(pending.data(),npending-1);
+    parseHeaderLine(line);
+    headerSize+=npending;
+    npending=0;
+  }
+  return true;
+}
+
+bool BinaryHillsReader::readRecord(std::vector<double>&record) {
+  if(!readHeader()) return false;
+  const size_t size=getRecordSize();
+  if(!fillPending(size)) return false;
+  record.resize(fields.size());
+  std::memcpy(record.data(),pending.data(),size);
+  npending=0;
+  nrecords++;
+  return true;
+}
+
+unsigned BinaryHillsReader::getFieldIndex(const std::string&name)const {
+  const auto f=fieldIndex.find(name);
+  plumed_massert(f!=fieldIndex.end(),"file "+ifile.getPath()+": cannot find field "+name);
+  return f->second;
+}
+
+bool BinaryHillsReader::constantExist(const std::string&name)const {
+  for(const auto & c : constants) if(c.first==name) return true;
+  return false;
+}
+
+const std::string& BinaryHillsReader::getConstant(const std::string&name)const {
+  for(const auto & c : constants) if(c.first==name) return c.second;
+  plumed_merror("file "+ifile.getPath()+": cannot find constant field "+name);
+}
+
+BinaryHillsWriter::BinaryHillsWriter(OFile&ofile,const std::vector<std::string>&fields,const std::vector<std::pair<std::string,std::string> >&constants):
+  ofile(ofile),
+  fields(fields),
+  constants(constants)
+{
+}
+
+void BinaryHillsWriter::writeHeader() {
+  std::string version; Tools::convert(binaryHillsVersion,version);
+  std::string header=std::string(binaryHillsMagic)+" "+version+" "+endianness()+"\n";
+  header+="#! FIELDS";
+  for(const auto & f : fields) header+=" "+f;
+  header+="\n";
+  for(const auto & c : constants) header+="#! SET "+c.first+" "+c.second+"\n";
+  header+="#! END\n";
+  ofile.writeBytes(header.c_str(),header.length());
+}
+
+void BinaryHillsWriter::writeRecord(const std::vector<double>&record) {
+  plumed_assert(record.size()==fields.size());
+  ofile.writeBytes(reinterpret_cast<const char*>(record.data()),record.size()*sizeof(double));
+}
+
+}
@@ -0,0 +1,123 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_BinaryHills_h
+#define __PLUMED_tools_BinaryHills_h
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace PLMD {
+
+class IFile;
+class OFile;
+
+/**
+\ingroup TOOLBOX
+Reader and writer for hills files in binary format.
+
+A binary hills file starts with the same header that is found in the corresponding
+text file (the FIELDS and SET lines), enclosed between a line "#! BINARY_HILLS <version> <endianness>"
+and a line "#! END". The header is followed by one record per hill, containing the values of all the
+fields in the FIELDS line as doubles. Since all the records have the same size, the k-th hill
+is found at getHeaderSize()+k*getRecordSize() bytes from the beginning of the file.
+
+Records can be read incrementally while another process is appending them to the same file
+(as it happens with multiple walkers): an incomplete header or record is kept and completed
+at the next call.
+*/
+class BinaryHillsReader {
+/// The file
+  IFile& ifile;
+/// Bytes already read that do not form a complete header line or record yet
+  std::vector<char> pending;
+/// Number of bytes in pending
+  size_t npending;
+/// True when the whole header has been read
+  bool headerDone;
+/// Size of the header in bytes
+  size_t headerSize;
+/// Names of the fields in each record
+  std::vector<std::string> fields;
+/// Index of each field in the records
+  std::map<std::string,unsigned> fieldIndex;
+/// Constant fields, in the order they appear in the header
+  std::vector<std::pair<std::string,std::string> > constants;
+/// Number of records read so far
+  unsigned long nrecords;
+/// Try to complete pending up to n bytes
+  bool fillPending(size_t n);
+/// Parse a line of the header
+  void parseHeaderLine(const std::string&);
+public:
+/// The reader takes an already open file
+  explicit BinaryHillsReader(IFile&);
+/// Check if the file at path is a binary hills file
+  static bool isBinary(const std::string&path);
+/// Read the header. Returns false if the header is not complete yet
+  bool readHeader();
+/// Read the next record. Returns false if no complete record is available
+  bool readRecord(std::vector<double>&record);
+/// Get the names of the fields in each record
+  const std::vector<std::string>& getFields()const {return fields;}
+/// Check if a field exists
+  bool fieldExist(const std::string&name)const {return fieldIndex.count(name)>0;}
+/// Get the position of a field in the records
+  unsigned getFieldIndex(const std::string&name)const;
+/// Get the constant fields
+  const std::vector<std::pair<std::string,std::string> >& getConstants()const {return constants;}
+/// Check if a constant field exists
+  bool constantExist(const std::string&name)const;
+/// Get the value of a constant field
+  const std::string& getConstant(const std::string&name)const;
+/// Size of the header in bytes
+  size_t getHeaderSize()const {return headerSize;}
+/// Size of each record in bytes
+  size_t getRecordSize()const {return fields.size()*sizeof(double);}
+/// Number of records read so far
+  unsigned long getNumberOfRecords()const {return nrecords;}
+};
+
+/// Writer for hills files in binary format, see BinaryHillsReader
+class BinaryHillsWriter {
+/// The file
+  OFile& ofile;
+/// Names of the fields in each record
+  std::vector<std::string> fields;
+/// Constant fields
+  std::vector<std::pair<std::string,std::string> > constants;
+public:
+  BinaryHillsWriter(OFile&,const std::vector<std::string>&fields,const std::vector<std::pair<std::string,std::string> >&constants);
+/// Write the header. To be called only when the file is new
+  void writeHeader();
+/// Write a record with the values of all the fields
+  void writeRecord(const std::vector<double>&record);
+/// Get the names of the fields in each record
+  const std::vector<std::string>& getFields()const {return fields;}
+/// Get the constant fields
+  const std::vector<std::pair<std::string,std::string> >& getConstants()const {return constants;}
+};
+
+}
+
+#endif
@@ -36,11 +36,14 @@
 #include <cstdio>
 #include <cfloat>
 #include <array>
+#include <algorithm>
+#include <cstdint>
 
 using namespace std;
 namespace PLMD {
 
 constexpr size_t Grid::maxdim;
+constexpr unsigned Grid::defaultsparsetilesize;
 
 Grid::Grid(const std::string& funcl, const std::vector<Value*> & args, const vector<std::string> & gmin,
            const vector<std::string> & gmax, const vector<unsigned> & nbin, bool dospline, bool usederiv, bool doclear) {
@@ -122,15 +125,8 @@ void Grid::Init(const std::string& funcl, const std::vector<std::string> &names,
 }
 
 void Grid::clear() {
-  grid_.resize(maxsize_);
-  if(usederiv_) der_.resize(maxsize_);
-  for(index_t i=0; i<maxsize_; ++i) {
-    grid_[i]=0.0;
-    if(usederiv_) {
-      (der_[i]).resize(dimension_);
-      for(unsigned int j=0; j<dimension_; ++j) der_[i][j]=0.0;
-    }
-  }
+  grid_.assign(maxsize_,0.0);
+  if(usederiv_) der_.assign(maxsize_*dimension_,0.0);
 }
 
 vector<std::string> Grid::getMin() const {
@@ -451,7 +447,8 @@ double Grid::getValue(const vector<double> & x) const {
 double Grid::getValueAndDerivatives
 (index_t index, vector<double>& der) const {
   plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  der=der_[index];
+  const double* pder=&der_[dimension_*index];
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=pder[i];
   return grid_[index];
 }
 
@@ -526,7 +523,8 @@ void Grid::setValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
   grid_[index]=value;
-  der_[index]=der;
+  double* pder=&der_[dimension_*index];
+  for(unsigned int i=0; i<dimension_; ++i) pder[i]=der[i];
 }
 
 void Grid::setValueAndDerivatives
@@ -547,7 +545,8 @@ void Grid::addValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_dbg_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
   grid_[index]+=value;
-  for(unsigned int i=0; i<dimension_; ++i) der_[index][i]+=der[i];
+  double* pder=&der_[dimension_*index];
+  for(unsigned int i=0; i<dimension_; ++i) pder[i]+=der[i];
 }
 
 void Grid::addValueAndDerivatives
@@ -555,26 +554,26 @@ void Grid::addValueAndDerivatives
   addValueAndDerivatives(getIndex(indices),value,der);
 }
 
-void Grid::scaleAllValuesAndDerivatives( const double& scalef ) {
-  if(usederiv_) {
-    for(index_t i=0; i<grid_.size(); ++i) {
-      grid_[i]*=scalef;
-      for(unsigned j=0; j<dimension_; ++j) der_[i][j]*=scalef;
-    }
-  } else {
-    for(index_t i=0; i<grid_.size(); ++i) grid_[i]*=scalef;
+void Grid::addValuesAndDerivatives
+(const vector<index_t> & indices, const vector<double> & values, const vector<double> & der) {
+  plumed_dbg_assert(usederiv_ && values.size()==indices.size() && der.size()==dimension_*indices.size());
+  for(index_t i=0; i<indices.size(); ++i) {
+    const index_t index=indices[i];
+    plumed_dbg_assert(index<maxsize_);
+    grid_[index]+=values[i];
+    double* pder=&der_[dimension_*index];
+    for(unsigned j=0; j<dimension_; ++j) pder[j]+=der[dimension_*i+j];
   }
 }
 
+void Grid::scaleAllValuesAndDerivatives( const double& scalef ) {
+  for(index_t i=0; i<grid_.size(); ++i) grid_[i]*=scalef;
+  if(usederiv_) for(index_t i=0; i<der_.size(); ++i) der_[i]*=scalef;
+}
+
 void Grid::logAllValuesAndDerivatives( const double& scalef ) {
-  if(usederiv_) {
-    for(index_t i=0; i<grid_.size(); ++i) {
-      grid_[i] = scalef*log(grid_[i]);
-      for(unsigned j=0; j<dimension_; ++j) der_[i][j] = scalef/der_[i][j];
-    }
-  } else {
-    for(index_t i=0; i<grid_.size(); ++i) grid_[i] = scalef*log(grid_[i]);
-  }
+  for(index_t i=0; i<grid_.size(); ++i) grid_[i] = scalef*log(grid_[i]);
+  if(usederiv_) for(index_t i=0; i<der_.size(); ++i) der_[i] = scalef/der_[i];
 }
 
 void Grid::setMinToZero() {
@@ -584,14 +583,8 @@ void Grid::setMinToZero() {
 }
 
 void Grid::applyFunctionAllValuesAndDerivatives( double (*func)(double val), double (*funcder)(double valder) ) {
-  if(usederiv_) {
-    for(index_t i=0; i<grid_.size(); ++i) {
-      grid_[i]=func(grid_[i]);
-      for(unsigned j=0; j<dimension_; ++j) der_[i][j]=funcder(der_[i][j]);
-    }
-  } else {
-    for(index_t i=0; i<grid_.size(); ++i) grid_[i]=func(grid_[i]);
-  }
+  for(index_t i=0; i<grid_.size(); ++i) grid_[i]=func(grid_[i]);
+  if(usederiv_) for(index_t i=0; i<der_.size(); ++i) der_[i]=funcder(der_[i]);
 }
 
 void Grid::writeHeader(OFile& ofile) {
@@ -604,25 +597,35 @@ void Grid::writeHeader(OFile& ofile) {
 }
 
 void Grid::writeToFile(OFile& ofile) {
+  vector<unsigned> indices(dimension_);
   vector<double> xx(dimension_);
-  vector<double> der(dimension_);
   double f;
   writeHeader(ofile);
+// field names are built once, not at every grid point
+  vector<string> minnames(dimension_), maxnames(dimension_), nbinnames(dimension_), pbcnames(dimension_), dernames(dimension_);
+  for(unsigned j=0; j<dimension_; ++j) {
+    minnames[j]="min_" + argnames[j];
+    maxnames[j]="max_" + argnames[j];
+    nbinnames[j]="nbins_" + argnames[j];
+    pbcnames[j]="periodic_" + argnames[j];
+    dernames[j]="der_" + argnames[j];
+  }
+  ofile.fmtField(" "+fmt_);
   for(index_t i=0; i<getSize(); ++i) {
-    xx=getPoint(i);
-    if(usederiv_) {f=getValueAndDerivatives(i,der);}
-    else {f=getValue(i);}
-    if(i>0 && dimension_>1 && getIndices(i)[dimension_-2]==0) ofile.printf("\n");
+    getIndices(i,indices);
+    getPoint(indices,xx);
+    f=grid_[i];
+    if(i>0 && dimension_>1 && indices[dimension_-2]==0) ofile.printf("\n");
     for(unsigned j=0; j<dimension_; ++j) {
-      ofile.printField("min_" + argnames[j], str_min_[j] );
-      ofile.printField("max_" + argnames[j], str_max_[j] );
-      ofile.printField("nbins_" + argnames[j], static_cast<int>(nbin_[j]) );
-      if( pbc_[j] ) ofile.printField("periodic_" + argnames[j], "true" );
-      else          ofile.printField("periodic_" + argnames[j], "false" );
+      ofile.printField(minnames[j], str_min_[j] );
+      ofile.printField(maxnames[j], str_max_[j] );
+      ofile.printField(nbinnames[j], static_cast<int>(nbin_[j]) );
+      if( pbc_[j] ) ofile.printField(pbcnames[j], "true" );
+      else          ofile.printField(pbcnames[j], "false" );
     }
-    for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField(argnames[j],xx[j]); }
-    ofile.fmtField(" "+fmt_); ofile.printField(funcname,f);
-    if(usederiv_) for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField("der_" + argnames[j],der[j]); }
+    for(unsigned j=0; j<dimension_; ++j) ofile.printField(argnames[j],xx[j]);
+    ofile.printField(funcname,f);
+    if(usederiv_) for(unsigned j=0; j<dimension_; ++j) ofile.printField(dernames[j],der_[dimension_*i+j]);
     ofile.printField();
   }
 }
@@ -651,8 +654,9 @@ void Grid::writeCubeFile(OFile& ofile, const double& lunit) {
 
 std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile,
                                    const vector<std::string> & gmin,const vector<std::string> & gmax,
-                                   const vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder) {
-  std::unique_ptr<Grid> grid=Grid::create(funcl,args,ifile,dosparse,dospline,doder);
+                                   const vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder,
+                                   unsigned sparsetilesize) {
+  std::unique_ptr<Grid> grid=Grid::create(funcl,args,ifile,dosparse,dospline,doder,sparsetilesize);
   std::vector<unsigned> cbin( grid->getNbin() );
   std::vector<std::string> cmin( grid->getMin() ), cmax( grid->getMax() );
   for(unsigned i=0; i<args.size(); ++i) {
@@ -667,7 +671,8 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
   return grid;
 }
 
-std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder)
+std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder,
+                                   unsigned sparsetilesize)
 {
   std::unique_ptr<Grid> grid;
   unsigned nvar=args.size(); bool hasder=false; std::string pstring;
@@ -704,7 +709,7 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
   }
 
   if(!dosparse) {grid.reset(new Grid(funcl,args,gmin,gmax,gbin,dospline,doder));}
-  else {grid.reset(new SparseGrid(funcl,args,gmin,gmax,gbin,dospline,doder));}
+  else {grid.reset(new SparseGrid(funcl,args,gmin,gmax,gbin,dospline,doder,sparsetilesize));}
 
   vector<double> xx(nvar),dder(nvar);
   vector<double> dx=grid->getDx();
@@ -726,13 +731,83 @@ std::unique_ptr<Grid> Grid::create(const std::string& funcl, const std::vector<V
   return grid;
 }
 
-// Sparse version of grid with map
+// Sparse version of grid with hashed tiles
+constexpr Grid::index_t SparseGrid::emptykey_;
+
+SparseGrid::SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+                       const std::vector<std::string> & gmax,
+                       const std::vector<unsigned> & nbin, bool dospline, bool usederiv, unsigned tilesize):
+  Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false),
+  tilesize_(tilesize),
+  pointsize_(usederiv?dimension_+1:1),
+  npoints_(0)
+{
+  plumed_massert(tilesize_>0,"sparse grid tile size must be greater than zero");
+  clear();
+}
+
 void SparseGrid::clear() {
-  map_.clear();
+  npoints_=0;
+  hashkeys_.assign(64,emptykey_);
+  hashslots_.assign(64,0);
+  tiles_.clear();
+  data_.clear();
+  occupied_.clear();
 }
 
 Grid::index_t SparseGrid::getSize() const {
-  return map_.size();
+  return npoints_;
+}
+
+Grid::index_t SparseGrid::hashSlot(index_t tile) const {
+// Fibonacci hashing followed by linear probing, the table size is a power of two
+  const index_t mask=hashkeys_.size()-1;
+  index_t slot=(static_cast<uint64_t>(tile)*UINT64_C(11400714819323198485))>>17;
+  slot&=mask;
+  while(hashkeys_[slot]!=emptykey_ && hashkeys_[slot]!=tile) slot=(slot+1)&mask;
+  return slot;
+}
+
+Grid::index_t SparseGrid::findTile(index_t tile) const {
+  const index_t slot=hashSlot(tile);
+  if(hashkeys_[slot]==emptykey_) return emptykey_;
+  return hashslots_[slot];
+}
+
+Grid::index_t SparseGrid::getTile(index_t tile) {
+  index_t slot=hashSlot(tile);
+  if(hashkeys_[slot]!=emptykey_) return hashslots_[slot];
+// keep the load factor below one half
+  if(2*(tiles_.size()+1)>hashkeys_.size()) {
+    hashkeys_.assign(2*hashkeys_.size(),emptykey_);
+    hashslots_.assign(hashkeys_.size(),0);
+    for(index_t i=0; i<tiles_.size(); ++i) {
+      const index_t s=hashSlot(tiles_[i]);
+      hashkeys_[s]=tiles_[i]; hashslots_[s]=i;
+    }
+    slot=hashSlot(tile);
+  }
+  const index_t itile=tiles_.size();
+  hashkeys_[slot]=tile; hashslots_[slot]=itile;
+  tiles_.push_back(tile);
+  data_.resize(data_.size()+tilesize_*pointsize_,0.0);
+  occupied_.resize(occupied_.size()+tilesize_,0);
+  return itile;
+}
+
+double* SparseGrid::getPointData(index_t index) {
+  const index_t itile=getTile(index/tilesize_);
+  const index_t ipoint=itile*tilesize_+index%tilesize_;
+  if(!occupied_[ipoint]) { occupied_[ipoint]=1; npoints_++; }
+  return &data_[ipoint*pointsize_];
+}
+
+const double* SparseGrid::findPointData(index_t index) const {
+  const index_t itile=findTile(index/tilesize_);
+  if(itile==emptykey_) return NULL;
+  const index_t ipoint=itile*tilesize_+index%tilesize_;
+  if(!occupied_[ipoint]) return NULL;
+  return &data_[ipoint*pointsize_];
 }
 
 Grid::index_t SparseGrid::getMaxSize() const {
@@ -788,47 +863,65 @@ void Grid::findSetOfPointsOnContour(const double& target, const std::vector<bool
 
 double SparseGrid::getValue(index_t index)const {
   plumed_assert(index<maxsize_);
-  double value=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  return value;
+  const double* pdata=findPointData(index);
+  if(pdata) return pdata[0];
+  return 0.0;
 }
 
 double SparseGrid::getValueAndDerivatives
 (index_t index, vector<double>& der)const {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  double value=0.0;
-  for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
-  const auto it=map_.find(index);
-  if(it!=map_.end()) value=it->second;
-  const auto itder=der_.find(index);
-  if(itder!=der_.end()) der=itder->second;
-  return value;
+  const double* pdata=findPointData(index);
+  if(!pdata) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=pdata[1+i];
+  return pdata[0];
 }
 
 void SparseGrid::setValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]=value;
+  getPointData(index)[0]=value;
 }
 
 void SparseGrid::setValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]=value;
-  der_[index]=der;
+  double* pdata=getPointData(index);
+  pdata[0]=value;
+  for(unsigned int i=0; i<dimension_; ++i) pdata[1+i]=der[i];
 }
 
 void SparseGrid::addValue(index_t index, double value) {
   plumed_assert(index<maxsize_ && !usederiv_);
-  map_[index]+=value;
+  getPointData(index)[0]+=value;
 }
 
 void SparseGrid::addValueAndDerivatives
 (index_t index, double value, vector<double>& der) {
   plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
-  map_[index]+=value;
-  der_[index].resize(dimension_);
-  for(unsigned int i=0; i<dimension_; ++i) der_[index][i]+=der[i];
+  double* pdata=getPointData(index);
+  pdata[0]+=value;
+  for(unsigned int i=0; i<dimension_; ++i) pdata[1+i]+=der[i];
+}
+
+void SparseGrid::addValuesAndDerivatives
+(const vector<index_t> & indices, const vector<double> & values, const vector<double> & der) {
+  plumed_assert(usederiv_ && values.size()==indices.size() && der.size()==dimension_*indices.size());
+// consecutive indices usually fall in the same tile, so the last one is cached
+  index_t lasttile=emptykey_, itile=0;
+  for(index_t i=0; i<indices.size(); ++i) {
+    const index_t index=indices[i];
+    plumed_assert(index<maxsize_);
+    const index_t tile=index/tilesize_;
+    if(tile!=lasttile) { itile=getTile(tile); lasttile=tile; }
+    const index_t ipoint=itile*tilesize_+index%tilesize_;
+    if(!occupied_[ipoint]) { occupied_[ipoint]=1; npoints_++; }
+    double* pdata=&data_[ipoint*pointsize_];
+    pdata[0]+=values[i];
+    for(unsigned j=0; j<dimension_; ++j) pdata[1+j]+=der[dimension_*i+j];
+  }
 }
 
 void SparseGrid::writeToFile(OFile& ofile) {
@@ -837,8 +930,14 @@ void SparseGrid::writeToFile(OFile& ofile) {
   double f;
   writeHeader(ofile);
   ofile.fmtField(" "+fmt_);
-  for(const auto & it : map_) {
-    index_t i=it.first;
+// points are written in increasing index order
+  vector<index_t> stored;
+  stored.reserve(npoints_);
+  for(index_t itile=0; itile<tiles_.size(); ++itile) {
+    for(unsigned k=0; k<tilesize_; ++k) if(occupied_[itile*tilesize_+k]) stored.push_back(tiles_[itile]*tilesize_+k);
+  }
+  std::sort(stored.begin(),stored.end());
+  for(const auto & i : stored) {
     xx=getPoint(i);
     if(usederiv_) {f=getValueAndDerivatives(i,der);}
     else {f=getValue(i);}
@@ -1001,7 +1100,7 @@ double Grid::integrate( std::vector<unsigned>& npoints ) {
 }
 
 void Grid::mpiSumValuesAndDerivatives( Communicator& comm ) {
-  comm.Sum( grid_ ); for(unsigned i=0; i<der_.size(); ++i) comm.Sum( der_[i] );
+  comm.Sum( grid_ ); if( der_.size()>0 ) comm.Sum( der_ );
 }
 
 
@@ -80,10 +80,13 @@ public:
 /// Maximum dimension (exaggerated value).
 /// Can be used to replace local std::vectors with std::arrays (allocated on stack).
   static constexpr size_t maxdim=64;
+/// Default number of consecutive grid points stored in a tile of a SparseGrid
+  static constexpr unsigned defaultsparsetilesize=8;
 private:
   double contour_location;
   std::vector<double> grid_;
-  std::vector< std::vector<double> > der_;
+/// derivatives stored contiguously, dimension_ values per grid point
+  std::vector<double> der_;
 protected:
   std::string funcname;
   std::vector<std::string> argnames;
@@ -163,11 +166,13 @@ public:
   void writeHeader(OFile& file);
 
 /// read grid from file
-  static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool);
+  static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool,
+                                      unsigned sparsetilesize=defaultsparsetilesize);
 /// read grid from file and check boundaries are what is expected from input
   static std::unique_ptr<Grid> create(const std::string&,const std::vector<Value*>&, IFile&,
                                       const std::vector<std::string>&,const std::vector<std::string>&,
-                                      const std::vector<unsigned>&,bool,bool,bool);
+                                      const std::vector<unsigned>&,bool,bool,bool,
+                                      unsigned sparsetilesize=defaultsparsetilesize);
 /// get grid size
   virtual index_t getSize() const;
 /// get grid value
@@ -199,6 +204,8 @@ public:
 /// add to grid value and derivatives
   virtual void addValueAndDerivatives(index_t index, double value, std::vector<double>& der);
   virtual void addValueAndDerivatives(const std::vector<unsigned> & indices, double value, std::vector<double>& der);
+/// add to grid values and derivatives of a batch of points (der holds getDimension() values per point)
+  virtual void addValuesAndDerivatives(const std::vector<index_t> & indices, const std::vector<double> & values, const std::vector<double> & der);
 /// Scale all grid values and derivatives by a constant factor
   virtual void scaleAllValuesAndDerivatives( const double& scalef );
 /// Takes the scalef times the logarithm of all grid values and derivatives
@@ -237,9 +244,34 @@ public:
 
 class SparseGrid : public Grid
 {
-
-  std::map<index_t,double> map_;
-  std::map< index_t,std::vector<double> > der_;
+/// Points are stored in tiles of tilesize_ consecutive grid indices.
+/// Each tile keeps value and derivatives of its points next to each other
+/// and tiles are located through an open addressing hash table.
+  unsigned tilesize_;
+/// number of doubles stored per point (value plus derivatives)
+  unsigned pointsize_;
+/// number of points that have been set at least once
+  index_t npoints_;
+/// hash table: tile number (or emptykey_) and position of the tile in tiles_
+  std::vector<index_t> hashkeys_;
+  std::vector<index_t> hashslots_;
+/// tile number of each stored tile
+  std::vector<index_t> tiles_;
+/// values and derivatives of the stored tiles
+  std::vector<double> data_;
+/// flags marking the stored points that have been set
+  std::vector<char> occupied_;
+  static constexpr index_t emptykey_=static_cast<index_t>(-1);
+/// hash table slot where a tile is or should be stored
+  index_t hashSlot(index_t tile) const;
+/// position in tiles_ of a tile, or emptykey_ if it is not stored
+  index_t findTile(index_t tile) const;
+/// position in tiles_ of a tile, which is created if needed
+  index_t getTile(index_t tile);
+/// pointer to the data of a point, which is created if needed
+  double* getPointData(index_t index);
+/// pointer to the data of a point, or NULL if it has never been set
+  const double* findPointData(index_t index) const;
 
 protected:
   void clear();
@@ -247,11 +279,13 @@ protected:
 public:
   SparseGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
              const std::vector<std::string> & gmax,
-             const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
-    Grid(funcl,args,gmin,gmax,nbin,dospline,usederiv,false) {}
+             const std::vector<unsigned> & nbin, bool dospline, bool usederiv,
+             unsigned tilesize=defaultsparsetilesize);
 
   index_t getSize() const;
   index_t getMaxSize() const;
+/// get number of consecutive grid points stored in a tile
+  unsigned getTileSize() const {return tilesize_;}
 
 /// this is to access to Grid:: version of these methods (allowing overloading of virtual methods)
   using Grid::getValue;
@@ -274,6 +308,8 @@ public:
   void addValue(index_t index, double value);
 /// add to grid value and derivatives
   void addValueAndDerivatives(index_t index, double value, std::vector<double>& der);
+/// add to grid values and derivatives of a batch of points
+  void addValuesAndDerivatives(const std::vector<index_t> & indices, const std::vector<double> & values, const std::vector<double> & der);
 
 /// dump grid on file
   void writeToFile(OFile&);
@@ -246,6 +246,11 @@ void IFile::reset(bool reset) {
   return;
 }
 
+size_t IFile::readBytes(char*ptr,size_t s) {
+  plumed_massert(!inMiddleOfField,"file "+getPath()+": cannot read raw bytes in the middle of a field");
+  return llread(ptr,s);
+}
+
 void IFile::allowIgnoredFields() {
   ignoreFields=true;
 }
@@ -89,6 +89,9 @@ public:
   IFile& getline(std::string&);
 /// Reset end of file
   void reset(bool);
+/// Read raw bytes (e.g. from a binary file) and return the number of bytes actually read.
+/// After the end of the file, reset(false) allows reading data that are appended later
+  size_t readBytes(char*,size_t);
 /// Check if a field exist
   bool FieldExist(const std::string& s);
 /// Read in a value
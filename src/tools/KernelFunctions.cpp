@@ -21,6 +21,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "KernelFunctions.h"
 #include "IFile.h"
+#include "BinaryHills.h"
 #include <iostream>
 #include <cmath>
 
@@ -398,19 +399,54 @@ std::unique_ptr<KernelFunctions> KernelFunctions::read( IFile* ifile, const bool
   std::vector<double> sig;
   if( sss=="false" ) {
     sig.resize( valnames.size() );
-    for(unsigned i=0; i<valnames.size(); ++i) {
-      ifile->scanField("sigma_"+valnames[i],sig[i]);
-      if( !cholesky ) sig[i]=sqrt(sig[i]);
+    for(unsigned i=0; i<valnames.size(); ++i) ifile->scanField("sigma_"+valnames[i],sig[i]);
+  } else {
+    unsigned ncv=valnames.size();
+    for(unsigned i=0; i<ncv; ++i) {
+      for(unsigned j=0; j<ncv-i; j++) {
+        double l; ifile->scanField("sigma_" +valnames[j+i] + "_" + valnames[j], l ); sig.push_back(l);
+      }
+    }
+  }
+  return create( cc, sig, sss, ktype, cholesky, h );
+}
+
+std::unique_ptr<KernelFunctions> KernelFunctions::read( const BinaryHillsReader& reader, const std::vector<double>& record, const bool& cholesky, const std::vector<std::string>& valnames ) {
+  double h=record[reader.getFieldIndex("height")];
+  std::string sss=reader.getConstant("multivariate");
+  std::string ktype="gaussian"; if( reader.constantExist("kerneltype") ) ktype=reader.getConstant("kerneltype");
+  plumed_massert( sss=="false" || sss=="true" || sss=="von-misses", "multivariate flag must be either false, true or von-misses");
+
+  std::vector<double> cc( valnames.size() );
+  for(unsigned i=0; i<valnames.size(); ++i) cc[i]=record[reader.getFieldIndex(valnames[i])];
+
+  std::vector<double> sig;
+  if( sss=="false" ) {
+    for(unsigned i=0; i<valnames.size(); ++i) sig.push_back( record[reader.getFieldIndex("sigma_"+valnames[i])] );
+  } else {
+    unsigned ncv=valnames.size();
+    for(unsigned i=0; i<ncv; ++i) {
+      for(unsigned j=0; j<ncv-i; j++) sig.push_back( record[reader.getFieldIndex("sigma_" +valnames[j+i] + "_" + valnames[j])] );
     }
+  }
+  return create( cc, sig, sss, ktype, cholesky, h );
+}
+
+std::unique_ptr<KernelFunctions> KernelFunctions::create( const std::vector<double>& cc, const std::vector<double>& filesig, const std::string& mtype,
+    const std::string& ktype, const bool& cholesky, const double& h ) {
+  std::vector<double> sig( filesig );
+  if( mtype=="false" ) {
+    if( !cholesky ) for(unsigned i=0; i<sig.size(); ++i) sig[i]=sqrt(sig[i]);
     return std::unique_ptr<KernelFunctions>(new KernelFunctions( cc, sig, ktype, "DIAGONAL", h ) );
   }
 
-  unsigned ncv=valnames.size();
+  unsigned ncv=cc.size();
   sig.resize( (ncv*(ncv+1))/2 );
   Matrix<double> upper(ncv,ncv), lower(ncv,ncv), mymult( ncv, ncv ), invmatrix(ncv,ncv);
+  unsigned l=0;
   for(unsigned i=0; i<ncv; ++i) {
     for(unsigned j=0; j<ncv-i; j++) {
-      ifile->scanField("sigma_" +valnames[j+i] + "_" + valnames[j], lower(j+i,j) );
+      lower(j+i,j)=filesig[l]; l++;
       upper(j,j+i)=lower(j+i,j); mymult(j+i,j)=mymult(j,j+i)=lower(j+i,j);
     }
   }
@@ -420,7 +456,7 @@ std::unique_ptr<KernelFunctions> KernelFunctions::read( IFile* ifile, const bool
   for(unsigned i=0; i<ncv; i++) {
     for(unsigned j=i; j<ncv; j++) { sig[k]=invmatrix(i,j); k++; }
   }
-  if( sss=="true" ) return std::unique_ptr<KernelFunctions>(new KernelFunctions( cc, sig, ktype, "MULTIVARIATE", h ) );
+  if( mtype=="true" ) return std::unique_ptr<KernelFunctions>(new KernelFunctions( cc, sig, ktype, "MULTIVARIATE", h ) );
   return std::unique_ptr<KernelFunctions>(new KernelFunctions( cc, sig, ktype, "VON-MISSES", h ) );
 }
 
@@ -29,6 +29,8 @@
 
 namespace PLMD {
 
+class BinaryHillsReader;
+
 class KernelFunctions {
 private:
 /// Is the metric matrix diagonal
@@ -45,6 +47,9 @@ private:
   void setData( const std::vector<double>& at, const std::vector<double>& sig, const std::string& type, const std::string& mtype, const double& w );
 /// Convert the width into matrix form
   Matrix<double> getMatrix() const;
+/// Create a kernel from the widths as they are stored in hills files (sigmas or cholesky decomposition in band form)
+  static std::unique_ptr<KernelFunctions> create( const std::vector<double>& cc, const std::vector<double>& filesig, const std::string& mtype,
+      const std::string& ktype, const bool& cholesky, const double& h );
 public:
   explicit KernelFunctions( const std::string& input );
   KernelFunctions( const std::vector<double>& at, const std::vector<double>& sig, const std::string& type, const std::string& mtype, const double& w );
@@ -65,6 +70,8 @@ public:
   double evaluate( const std::vector<Value*>& pos, std::vector<double>& derivatives, bool usederiv=true, bool doInt=false, double lowI_=-1, double uppI_=-1 ) const;
 /// Read a kernel function from a file
   static std::unique_ptr<KernelFunctions> read( IFile* ifile, const bool& cholesky, const std::vector<std::string>& valnames );
+/// Read a kernel function from a record of a binary hills file
+  static std::unique_ptr<KernelFunctions> read( const BinaryHillsReader& reader, const std::vector<double>& record, const bool& cholesky, const std::vector<std::string>& valnames );
 };
 
 inline
@@ -24,6 +24,8 @@
 #include "Pbc.h"
 #include "AtomNumber.h"
 #include "Tools.h"
+#include "Communicator.h"
+#include "LinkCells.h"
 #include <vector>
 #include <algorithm>
 
@@ -66,6 +68,20 @@ NeighborList::NeighborList(const vector<AtomNumber>& list0, const bool& do_pbc,
   lastupdate_=0;
 }
 
+NeighborList::~NeighborList() {
+// destructor required to delete forward declared classes
+}
+
+void NeighborList::setUseLinkCells(bool uselinkcells) {
+  if(!uselinkcells) {
+    linkcells_.reset();
+    return;
+  }
+  if(!serialcomm_) serialcomm_.reset(new Communicator);
+  linkcells_.reset(new LinkCells(*serialcomm_));
+  linkcells_->setCutoff(distance_);
+}
+
 void NeighborList::initialize() {
   neighbors_.clear();
   for(unsigned int i=0; i<nallpairs_; ++i) {
@@ -97,6 +113,11 @@ void NeighborList::update(const vector<Vector>& positions) {
   const double d2=distance_*distance_;
 // check if positions array has the correct length
   plumed_assert(positions.size()==fullatomlist_.size());
+  if(linkcells_ && !(twolists_ && do_pair_)) {
+    updateWithLinkCells(positions);
+    setRequestList();
+    return;
+  }
   for(unsigned int i=0; i<nallpairs_; ++i) {
     pair<unsigned,unsigned> index=getIndexPair(i);
     unsigned index0=index.first;
@@ -113,6 +134,52 @@ void NeighborList::update(const vector<Vector>& positions) {
   setRequestList();
 }
 
+void NeighborList::updateWithLinkCells(const vector<Vector>& positions) {
+  const double d2=distance_*distance_;
+// Without periodic boundaries the cells are built in an orthorhombic box enclosing all the atoms.
+// Periodic images can then only add candidates, which are discarded when computing distances.
+  Pbc cellpbc;
+  if(do_pbc_ && pbc_->isSet()) {
+    cellpbc.setBox(pbc_->getBox());
+  } else {
+    Vector lower(positions[0]), upper(positions[0]);
+    for(unsigned i=1; i<positions.size(); ++i) for(unsigned k=0; k<3; ++k) {
+        lower[k]=std::min(lower[k],positions[i][k]);
+        upper[k]=std::max(upper[k],positions[i][k]);
+      }
+    Tensor box;
+    for(unsigned k=0; k<3; ++k) box(k,k)=upper[k]-lower[k]+distance_;
+    cellpbc.setBox(box);
+  }
+// With two lists the cells contain the second one and are searched with the atoms of the first one
+  const unsigned first=(twolists_ ? nlist0_ : 0);
+  vector<Vector> cellpos(positions.begin()+first,positions.end());
+  vector<unsigned> cellind(cellpos.size());
+  for(unsigned i=0; i<cellind.size(); ++i) cellind[i]=first+i;
+  linkcells_->buildCellLists(cellpos,cellind,cellpbc);
+
+// Close pairs are stored in the same order as when looping over all pairs
+  vector<unsigned> cell_list, atoms(positions.size()+1), close;
+  for(unsigned i=0; i<nlist0_; ++i) {
+    unsigned natomsper=1; atoms[0]=i;
+    linkcells_->retrieveNeighboringAtoms(positions[i],cell_list,natomsper,atoms);
+    close.clear();
+    for(unsigned k=1; k<natomsper; ++k) {
+      const unsigned j=atoms[k];
+      if(!twolists_ && j<i) continue;
+      Vector distance;
+      if(do_pbc_) {
+        distance=pbc_->distance(positions[i],positions[j]);
+      } else {
+        distance=delta(positions[i],positions[j]);
+      }
+      if(modulo2(distance)<=d2) close.push_back(j);
+    }
+    std::sort(close.begin(),close.end());
+    for(unsigned k=0; k<close.size(); ++k) neighbors_.push_back(pair<unsigned,unsigned>(i,close[k]));
+  }
+}
+
 void NeighborList::setRequestList() {
   requestlist_.clear();
   for(unsigned int i=0; i<size(); ++i) {
@@ -129,8 +196,8 @@ vector<AtomNumber>& NeighborList::getReducedAtomList() {
       AtomNumber index0=fullatomlist_[neighbors_[i].first];
       AtomNumber index1=fullatomlist_[neighbors_[i].second];
 // I exploit the fact that requestlist_ is an ordered vector
-      auto p = std::find(requestlist_.begin(), requestlist_.end(), index0); plumed_assert(p!=requestlist_.end()); newindex0=p-requestlist_.begin();
-      p = std::find(requestlist_.begin(), requestlist_.end(), index1); plumed_assert(p!=requestlist_.end()); newindex1=p-requestlist_.begin();
+      auto p = std::lower_bound(requestlist_.begin(), requestlist_.end(), index0); plumed_assert(p!=requestlist_.end() && *p==index0); newindex0=p-requestlist_.begin();
+      p = std::lower_bound(requestlist_.begin(), requestlist_.end(), index1); plumed_assert(p!=requestlist_.end() && *p==index1); newindex1=p-requestlist_.begin();
       neighbors_[i]=pair<unsigned,unsigned>(newindex0,newindex1);
     }
   reduced=true;
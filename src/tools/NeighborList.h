@@ -26,10 +26,13 @@
 #include "AtomNumber.h"
 
 #include <vector>
+#include <memory>
 
 namespace PLMD {
 
 class Pbc;
+class Communicator;
+class LinkCells;
 
 /// \ingroup TOOLBOX
 /// A class that implements neighbor lists from two lists or a single list of atoms
@@ -42,6 +45,10 @@ class NeighborList
   std::vector<std::pair<unsigned,unsigned> > neighbors_;
   double distance_;
   unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_;
+/// Serial communicator used by the link cells
+  std::unique_ptr<Communicator> serialcomm_;
+/// Link cells used to find close pairs (if enabled)
+  std::unique_ptr<LinkCells> linkcells_;
 /// Initialize the neighbor list with all possible pairs
   void initialize();
 /// Return the pair of indexes in the positions array
@@ -49,6 +56,8 @@ class NeighborList
   std::pair<unsigned,unsigned> getIndexPair(unsigned i);
 /// Extract the list of atoms from the current list of close pairs
   void setRequestList();
+/// Update the list of close pairs using link cells
+  void updateWithLinkCells(const std::vector<PLMD::Vector>& positions);
 public:
   NeighborList(const std::vector<PLMD::AtomNumber>& list0,
                const std::vector<PLMD::AtomNumber>& list1,
@@ -66,6 +75,9 @@ public:
 /// Update the neighbor list and prepare the new
 /// list of atoms that will be requested to the main code
   void update(const std::vector<PLMD::Vector>& positions);
+/// Use link cells to update the neighbor list, so that its cost grows
+/// linearly with the number of atoms rather than with the number of pairs
+  void setUseLinkCells(bool uselinkcells);
 /// Get the update stride of the neighbor list
   unsigned getStride() const;
 /// Get the last step in which the neighbor list was updated
@@ -78,7 +90,7 @@ public:
   std::pair<unsigned,unsigned> getClosePair(unsigned i) const;
 /// Get the list of neighbors of the i-th atom
   std::vector<unsigned> getNeighbors(unsigned i);
-  ~NeighborList() {}
+  ~NeighborList();
 /// Get the i-th pair of AtomNumbers from the neighbor list
   std::pair<AtomNumber,AtomNumber> getClosePairAtomNumber(unsigned i) const;
 };
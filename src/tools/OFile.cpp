@@ -194,6 +194,12 @@ OFile& OFile::printField(const std::string&name,const std::string & v) {
   return *this;
 }
 
+OFile& OFile::writeBytes(const char*ptr,size_t s) {
+  size_t r=llwrite(ptr,s);
+  plumed_massert(r==s,"file "+getPath()+": error writing binary data");
+  return *this;
+}
+
 OFile& OFile::setupPrintValue( Value *val ) {
   if( val->isPeriodic() ) {
     addConstantField("min_" + val->getName() );
@@ -251,6 +251,8 @@ public:
   OFile& clearFields();
 /// Formatted output with explicit format - a la printf
   int printf(const char*fmt,...);
+/// Write raw bytes (e.g. to a binary file)
+  OFile& writeBytes(const char*,size_t);
 /// Formatted output with << operator
   template <class T>
   friend OFile& operator<<(OFile&,const T &);
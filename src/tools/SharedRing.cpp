@@ -0,0 +1,237 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "SharedRing.h"
+#include "Exception.h"
+#include "Tools.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+#include <new>
+
+#ifdef __PLUMED_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace PLMD {
+
+namespace {
+
+/// Header stored at the beginning of the mapped file
+struct SharedRingHeader {
+/// Set to sharedRingMagic when the header is ready
+  std::atomic<std::uint64_t> magic;
+  std::uint64_t recordSize;
+  std::uint64_t capacity;
+/// Number of records reserved by the writers
+  std::atomic<std::uint64_t> next;
+/// Number of processes using the ring
+  std::atomic<std::uint64_t> users;
+};
+
+/// "PLMDRING"
+const std::uint64_t sharedRingMagic=0x504c4d4452494e47ULL;
+
+/// Size of the header, rounded to a cache line
+const std::size_t sharedRingHeaderSize=((sizeof(SharedRingHeader)+63)/64)*64;
+
+/// Maximum time waited for the header written by another process
+const std::chrono::seconds sharedRingTimeout(60);
+
+}
+
+SharedRing::SharedRing():
+  recordSize(0),
+  capacity(0),
+  slotSize(0),
+  mapSize(0),
+  mem(NULL),
+  cursor(0)
+{
+}
+
+SharedRing::~SharedRing() {
+// destructor should not throw
+  try {
+    close();
+  } catch(...) {
+  }
+}
+
+bool SharedRing::isAvailable() {
+#ifdef __PLUMED_HAS_MMAP
+  std::atomic<std::uint64_t> test(0);
+  return test.is_lock_free();
+#else
+  return false;
+#endif
+}
+
+char* SharedRing::getSlot(std::size_t i)const {
+  return mem+sharedRingHeaderSize+i*slotSize;
+}
+
+void SharedRing::open(const std::string& path,unsigned recordSize,std::size_t capacity) {
+  plumed_massert(!mem,"shared ring is already open");
+  plumed_massert(recordSize>0 && capacity>0,"shared ring should have non zero record size and capacity");
+  if(!isAvailable()) plumed_merror("shared memory rings are not available on this machine");
+#ifdef __PLUMED_HAS_MMAP
+  this->path=path;
+  this->recordSize=recordSize;
+  this->capacity=capacity;
+  cursor=0;
+// each slot contains the sequence number followed by the record, rounded to a cache line
+  slotSize=((sizeof(std::uint64_t)+recordSize*sizeof(double)+63)/64)*64;
+  mapSize=sharedRingHeaderSize+capacity*slotSize;
+
+// the first process creates the file, the others wait until it is ready
+  bool creator=true;
+  int fd=::open(path.c_str(),O_RDWR|O_CREAT|O_EXCL,0600);
+  if(fd<0 && errno==EEXIST) {
+    creator=false;
+    fd=::open(path.c_str(),O_RDWR);
+  }
+  if(fd<0) plumed_merror("cannot open shared memory file "+path+": "+std::strerror(errno));
+
+  const auto start=std::chrono::steady_clock::now();
+  if(creator) {
+    if(ftruncate(fd,mapSize)!=0) {
+      ::close(fd);
+      ::unlink(path.c_str());
+      plumed_merror("cannot allocate shared memory file "+path+": "+std::strerror(errno));
+    }
+  } else {
+    struct stat st;
+    while(true) {
+      if(fstat(fd,&st)!=0) {
+        ::close(fd);
+        plumed_merror("cannot access shared memory file "+path+": "+std::strerror(errno));
+      }
+      if(st.st_size>0) break;
+      if(std::chrono::steady_clock::now()-start>sharedRingTimeout) {
+        ::close(fd);
+        plumed_merror("timeout while waiting for shared memory file "+path+" to be allocated");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if(std::size_t(st.st_size)!=mapSize) {
+      ::close(fd);
+      std::string s; Tools::convert((long unsigned)st.st_size,s);
+      plumed_merror("shared memory file "+path+" has size "+s+", it was probably created with a different record size or capacity");
+    }
+  }
+
+  void* m=mmap(NULL,mapSize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+// the mapping stays valid after the file descriptor is closed
+  ::close(fd);
+  if(m==MAP_FAILED) {
+    if(creator) ::unlink(path.c_str());
+    plumed_merror("cannot map shared memory file "+path+": "+std::strerror(errno));
+  }
+  mem=static_cast<char*>(m);
+
+  SharedRingHeader* header=reinterpret_cast<SharedRingHeader*>(mem);
+  if(creator) {
+// memory is zeroed by ftruncate, so that all the sequence numbers are zero
+    new(header) SharedRingHeader;
+    header->recordSize=recordSize;
+    header->capacity=capacity;
+    header->next.store(0);
+    header->users.store(0);
+    header->magic.store(sharedRingMagic,std::memory_order_release);
+  } else {
+    while(header->magic.load(std::memory_order_acquire)!=sharedRingMagic) {
+      if(std::chrono::steady_clock::now()-start>sharedRingTimeout) {
+        munmap(mem,mapSize);
+        mem=NULL;
+        plumed_merror("timeout while waiting for the header of shared memory file "+path);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if(header->recordSize!=recordSize || header->capacity!=capacity) {
+      munmap(mem,mapSize);
+      mem=NULL;
+      plumed_merror("shared memory file "+path+" was created with a different record size or capacity");
+    }
+  }
+  header->users.fetch_add(1);
+#endif
+}
+
+void SharedRing::close() {
+#ifdef __PLUMED_HAS_MMAP
+  if(!mem) return;
+  SharedRingHeader* header=reinterpret_cast<SharedRingHeader*>(mem);
+// the last process removes the file
+  if(header->users.fetch_sub(1)==1) ::unlink(path.c_str());
+  munmap(mem,mapSize);
+  mem=NULL;
+#endif
+}
+
+void SharedRing::append(const std::vector<double>& record) {
+  plumed_massert(mem,"shared ring is not open");
+  plumed_massert(record.size()==recordSize,"wrong record size for shared ring");
+  SharedRingHeader* header=reinterpret_cast<SharedRingHeader*>(mem);
+  const std::uint64_t idx=header->next.fetch_add(1);
+  char* slot=getSlot(idx%capacity);
+  std::atomic<std::uint64_t>* seq=reinterpret_cast<std::atomic<std::uint64_t>*>(slot);
+// an odd sequence number marks a record that is being written
+  seq->store(2*idx+1,std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(slot+sizeof(std::uint64_t),&record[0],recordSize*sizeof(double));
+  seq->store(2*idx+2,std::memory_order_release);
+}
+
+bool SharedRing::read(std::vector<double>& record) {
+  plumed_massert(mem,"shared ring is not open");
+  record.resize(recordSize);
+  char* slot=getSlot(cursor%capacity);
+  std::atomic<std::uint64_t>* seq=reinterpret_cast<std::atomic<std::uint64_t>*>(slot);
+  const std::uint64_t expected=2*cursor+2;
+  const std::uint64_t s=seq->load(std::memory_order_acquire);
+// record not written yet, or still being written
+  if(s<expected) return false;
+  if(s==expected) {
+    std::memcpy(&record[0],slot+sizeof(std::uint64_t),recordSize*sizeof(double));
+    std::atomic_thread_fence(std::memory_order_acquire);
+// check that the slot was not overwritten while copying
+    if(seq->load(std::memory_order_relaxed)==expected) {
+      cursor++;
+      return true;
+    }
+  }
+  plumed_merror("records in shared memory file "+path+" were overwritten before being read, the capacity of the ring should be increased");
+  return false;
+}
+
+std::size_t SharedRing::getNumberOfRecords()const {
+  plumed_massert(mem,"shared ring is not open");
+  return reinterpret_cast<SharedRingHeader*>(mem)->next.load();
+}
+
+}
@@ -0,0 +1,98 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_SharedRing_h
+#define __PLUMED_tools_SharedRing_h
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+Lock-free append-only ring of fixed-size records shared among processes.
+
+The ring is stored in a file that is mapped in memory by all the processes
+that open it, so that the records appended by one process can be read by the
+others without any system call or collective communication.
+When the file is on a memory file system (e.g. /dev/shm) no disk access takes place.
+Writers reserve a slot with an atomic counter and then publish the record
+by updating a sequence number stored in the slot, so that no lock is needed.
+Each process keeps its own reading position. The ring has a fixed capacity,
+and a record that is overwritten before being read results in an error.
+The file is removed when the last process closes it.
+
+\verbatim
+  SharedRing ring;
+  ring.open("/dev/shm/ring",recordsize,capacity);
+  ring.append(record);
+  while(ring.read(record)) { use record }
+\endverbatim
+*/
+class SharedRing {
+/// Copy constructor is disabled
+  SharedRing(const SharedRing&) = delete;
+/// Assignment operator is disabled
+  SharedRing& operator=(const SharedRing&) = delete;
+/// Path of the mapped file
+  std::string path;
+/// Number of doubles in each record
+  unsigned recordSize;
+/// Maximum number of records stored at the same time
+  std::size_t capacity;
+/// Size of each slot in bytes, including the sequence number
+  std::size_t slotSize;
+/// Size of the mapped memory in bytes
+  std::size_t mapSize;
+/// Beginning of the mapped memory
+  char* mem;
+/// Index of the next record to be read by this process
+  std::size_t cursor;
+/// Get the address of slot i
+  char* getSlot(std::size_t i)const;
+public:
+  SharedRing();
+  ~SharedRing();
+/// Tells if shared rings are supported on this machine
+  static bool isAvailable();
+/// Open the ring stored in file path, creating it if it does not exist.
+/// All the processes should use the same recordSize and capacity
+  void open(const std::string& path,unsigned recordSize,std::size_t capacity);
+/// Close the ring. The file is removed if no other process is using it
+  void close();
+/// Tells if the ring is open
+  bool isOpen()const {return mem;}
+/// Append a record
+  void append(const std::vector<double>& record);
+/// Read the next record that was not read yet by this process.
+/// Returns false if no new complete record is available
+  bool read(std::vector<double>& record);
+/// Total number of records appended so far by all the processes
+  std::size_t getNumberOfRecords()const;
+/// Number of doubles in each record
+  unsigned getRecordSize()const {return recordSize;}
+};
+
+}
+
+#endif
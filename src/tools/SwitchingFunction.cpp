@@ -25,6 +25,7 @@
 #include "OpenMP.h"
 #include <vector>
 #include <limits>
+#include <algorithm>
 
 #define PI 3.14159265358979323846
 
@@ -416,6 +417,64 @@ double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
   }
 }
 
+void SwitchingFunction::calculateSqr(unsigned n,const double*distance2,double*result,double*dfunc)const {
+  if(type!=leptontype) {
+    for(unsigned i=0; i<n; i++) result[i]=calculateSqr(distance2[i],dfunc[i]);
+    return;
+  }
+  const unsigned t=OpenMP::getThreadNum();
+  plumed_assert(t<expression.size());
+// points within the cutoff are collected in chunks and passed together to lepton
+  const unsigned chunk=64;
+  double x[chunk],f[chunk],df[chunk],distance[chunk];
+  unsigned index[chunk];
+  std::map<std::string,const double*> inputs;
+  inputs[leptonx2?"x2":"x"]=x;
+  for(unsigned start=0; start<n; start+=chunk) {
+    const unsigned end=std::min(n,start+chunk);
+    unsigned k=0;
+    for(unsigned i=start; i<end; i++) {
+      if(leptonx2) {
+        if(distance2[i]>dmax_2) {
+          result[i]=0.0;
+          dfunc[i]=0.0;
+          continue;
+        }
+        x[k]=distance2[i]*invr0_2;
+      } else {
+        distance[k]=std::sqrt(distance2[i]);
+        if(distance[k]>dmax) {
+          result[i]=0.0;
+          dfunc[i]=0.0;
+          continue;
+        }
+        x[k]=(distance[k]-d0)*invr0;
+        if(x[k]<=0.) {
+          result[i]=stretch+shift;
+          dfunc[i]=0.0;
+          continue;
+        }
+      }
+      index[k]=i;
+      k++;
+    }
+    if(k==0) continue;
+    expression[t].evaluate(inputs,f,k);
+    expression_deriv[t].evaluate(inputs,df,k);
+    for(unsigned j=0; j<k; j++) {
+      double d=df[j];
+// chain rule:
+      if(leptonx2) d*=2*invr0_2;
+      else {
+        d*=invr0;
+        d/=distance[j];
+      }
+      result[index[j]]=f[j]*stretch+shift;
+      dfunc[index[j]]=d*stretch;
+    }
+  }
+}
+
 double SwitchingFunction::calculate(double distance,double&dfunc)const {
   plumed_massert(init,"you are trying to use an unset SwitchingFunction");
   if(distance>dmax) {
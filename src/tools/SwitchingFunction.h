@@ -110,6 +110,10 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Compute the switching function for n squared distances at once.
+/// Same as calling calculateSqr() on each of them, but lepton functions
+/// are evaluated in batches.
+  void calculateSqr(unsigned n,const double*distance2,double*result,double*dfunc)const;
 /// Returns d0
   double get_d0() const;
 /// Returns r0
@@ -0,0 +1,127 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_ThreadReduction_h
+#define __PLUMED_tools_ThreadReduction_h
+
+#include "Tensor.h"
+#include "Exception.h"
+#include <vector>
+#include <algorithm>
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+Per-thread accumulation buffers that are summed in parallel.
+
+Each OpenMP thread accumulates its contributions (e.g. derivatives
+with respect to atomic positions and virial) in its own buffer.
+The buffers are then summed at the end of the parallel region, with the
+elements partitioned in contiguous blocks among the threads, so that no
+critical section is needed. The buffers are kept across calls so
+that memory is not reallocated at every step.
+
+\verbatim
+  reduction.resize(nt,natoms);
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<Vector> & myderiv(reduction.getBuffer(OpenMP::getThreadNum()));
+    Tensor & myvirial(reduction.getVirial(OpenMP::getThreadNum()));
+    #pragma omp for nowait
+    for(...) { accumulate on myderiv and myvirial }
+    reduction.reduce(deriv,virial);
+  }
+\endverbatim
+*/
+template<typename T>
+class ThreadReduction {
+/// The buffers of the single threads
+  std::vector<std::vector<T> > buffers;
+/// The virial of the single threads
+  std::vector<Tensor> virials;
+/// Flags telling which threads have actually been accumulating
+  std::vector<unsigned char> used;
+/// Size of each buffer
+  unsigned n;
+public:
+  ThreadReduction(): n(0) {}
+/// Set the number of threads and the size of the buffers.
+/// To be called outside the parallel region before each use.
+  void resize(unsigned nt,unsigned size);
+/// Get the size of each buffer
+  unsigned size() const {return n;}
+/// Zero and get the buffer of thread t. To be called by thread t
+  std::vector<T> & getBuffer(unsigned t);
+/// Get the virial of thread t. It is zeroed by getBuffer()
+  Tensor & getVirial(unsigned t) {return virials[t];}
+/// Add the sum of the buffers to out.
+/// To be called by all the threads of the team at the end of the parallel region
+  void reduce(std::vector<T> & out);
+/// Add the sum of the buffers to out and the sum of the virials to virial.
+/// To be called by all the threads of the team at the end of the parallel region
+  void reduce(std::vector<T> & out,Tensor & virial);
+};
+
+template<typename T>
+void ThreadReduction<T>::resize(unsigned nt,unsigned size) {
+  if(buffers.size()!=nt) {
+    buffers.resize(nt);
+    virials.resize(nt);
+  }
+  n=size;
+  used.assign(nt,0);
+}
+
+template<typename T>
+std::vector<T> & ThreadReduction<T>::getBuffer(unsigned t) {
+  plumed_dbg_assert(t<buffers.size());
+  std::vector<T> & b(buffers[t]);
+// memory is touched first by the thread that is going to use it
+  if(b.size()!=n) b.assign(n,T());
+  else std::fill(b.begin(),b.end(),T());
+  virials[t].zero();
+  used[t]=1;
+  return b;
+}
+
+template<typename T>
+void ThreadReduction<T>::reduce(std::vector<T> & out) {
+  plumed_dbg_assert(out.size()>=n);
+  const unsigned nt=buffers.size();
+// all the threads should be done with their own buffer
+  #pragma omp barrier
+  #pragma omp for schedule(static)
+  for(unsigned i=0; i<n; i++) {
+    for(unsigned t=0; t<nt; t++) if(used[t]) out[i]+=buffers[t][i];
+  }
+}
+
+template<typename T>
+void ThreadReduction<T>::reduce(std::vector<T> & out,Tensor & virial) {
+  reduce(out);
+  #pragma omp single
+  for(unsigned t=0; t<virials.size(); t++) if(used[t]) virial+=virials[t];
+}
+
+}
+
+#endif
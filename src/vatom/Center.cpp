@@ -215,7 +215,6 @@ void Center::calculate() {
     first=false;
   }
 
-  vector<Tensor> deriv(getNumberOfAtoms());
   for(unsigned i=0; i<getNumberOfAtoms(); i++) mass+=getMass(i);
   if( plumed.getAtoms().chargesWereSet() ) {
     double charge(0.0);
@@ -228,6 +227,7 @@ void Center::calculate() {
   for(unsigned i=0; i<weights.size(); i++) wtot+=weights[i];
 
   if(dophases) {
+    vector<Tensor> deriv(getNumberOfAtoms());
     dcenter_sin.resize(getNumberOfAtoms());
     dcenter_cos.resize(getNumberOfAtoms());
     Vector center_sin;
@@ -288,12 +288,14 @@ void Center::calculate() {
 // scaled to real
     setPosition(matmul(c,box2pi));
   } else {
+// the derivatives are proportional to the identity, so only the weights are stored
+    vector<double> deriv(getNumberOfAtoms());
     for(unsigned i=0; i<getNumberOfAtoms(); i++) {
       double w=0;
       if(weight_mass) w=getMass(i)/mass;
       else w=weights[i]/wtot;
       pos+=w*getPosition(i);
-      deriv[i]=w*Tensor::identity();
+      deriv[i]=w;
     }
     setPosition(pos);
     setMass(mass);
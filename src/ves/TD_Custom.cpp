@@ -239,19 +239,32 @@ void TD_Custom::updateGrid() {
   std::vector<double> integration_weights = GridIntegrationWeights::getIntegrationWeights(getTargetDistGridPntr());
   double norm = 0.0;
   //
-  for(Grid::index_t l=0; l<targetDistGrid().getSize(); l++) {
+  // the function is evaluated on all the grid points at once
+  const Grid::index_t gsize = targetDistGrid().getSize();
+  std::vector<std::vector<double> > cv_values(cv_var_str_.size(),std::vector<double>(gsize));
+  std::vector<double> fes_values;
+  std::map<std::string,const double*> inputs;
+  for(Grid::index_t l=0; l<gsize; l++) {
     std::vector<double> point = targetDistGrid().getPoint(l);
     for(unsigned int k=0; k<cv_var_str_.size() ; k++) {
-      try {
-        expression.getVariableReference(cv_var_str_[k]) = point[cv_var_idx_[k]];
-      } catch(PLMD::lepton::Exception& exc) {}
+      cv_values[k][l] = point[cv_var_idx_[k]];
     }
-    if(use_fes_) {
-      try {
-        expression.getVariableReference(fes_var_str_) = getFesGridPntr()->getValue(l);
-      } catch(PLMD::lepton::Exception& exc) {}
+  }
+  for(unsigned int k=0; k<cv_var_str_.size() ; k++) {
+    inputs[cv_var_str_[k]] = cv_values[k].data();
+  }
+  if(use_fes_) {
+    fes_values.resize(gsize);
+    for(Grid::index_t l=0; l<gsize; l++) {
+      fes_values[l] = getFesGridPntr()->getValue(l);
     }
-    double value = expression.evaluate();
+    inputs[fes_var_str_] = fes_values.data();
+  }
+  std::vector<double> values(gsize);
+  expression.evaluate(inputs,values.data(),gsize);
+  //
+  for(Grid::index_t l=0; l<gsize; l++) {
+    double value = values[l];
 
     if(value<0.0 && !isTargetDistGridShiftedToZero()) {plumed_merror(getName()+": The target distribution function gives negative values. You should change the definition of the function used for the target distribution to avoid this. You can also use the SHIFT_TO_ZERO keyword to avoid this problem.");}
     targetDistGrid().setValue(l,value);
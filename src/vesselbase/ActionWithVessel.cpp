@@ -30,6 +30,7 @@
 #include "StoreDataVessel.h"
 #include "tools/OpenMP.h"
 #include "tools/Stopwatch.h"
+#include <chrono>
 
 using namespace std;
 namespace PLMD {
@@ -43,6 +44,8 @@ void ActionWithVessel::registerKeywords(Keywords& keys) {
   keys.add("hidden","MAXDERIVATIVES","The maximum number of derivatives that can be used when storing data.  This controls when "
            "we have to start using lowmem");
   keys.addFlag("SERIAL",false,"do the calculation in serial.  Do not parallelize");
+  keys.addFlag("BALANCE",false,"split the tasks among threads and processes according to the time they took at the previous step. "
+               "This can improve the load balance, but the order in which contributions are summed then changes from run to run");
   keys.addFlag("LOWMEM",false,"lower the memory requirements");
   keys.addFlag("TIMINGS",false,"output information on the timings of the various parts of the calculation");
   keys.reserveFlag("HIGHMEM",false,"use a more memory intensive version of this collective variable");
@@ -54,6 +57,7 @@ ActionWithVessel::ActionWithVessel(const ActionOptions&ao):
   serial(false),
   lowmem(false),
   noderiv(true),
+  balance(false),
   actionIsBridged(false),
   nactive_tasks(0),
   dertime_can_be_off(false),
@@ -66,6 +70,8 @@ ActionWithVessel::ActionWithVessel(const ActionOptions&ao):
   if( keywords.exists("SERIAL") ) parseFlag("SERIAL",serial);
   else serial=true;
   if(serial)log.printf("  doing calculation in serial\n");
+  if( keywords.exists("BALANCE") ) parseFlag("BALANCE",balance);
+  if(balance) log.printf("  tasks are split according to their cost at the previous step\n");
   if( keywords.exists("LOWMEM") ) {
     plumed_assert( !keywords.exists("HIGHMEM") );
     parseFlag("LOWMEM",lowmem);
@@ -282,43 +288,61 @@ void ActionWithVessel::runAllTasks() {
   // Switch off calculation of derivatives in main loop
   if( dertime_can_be_off ) dertime=false;
 
+  if( nt>1 ) reduction.resize( nt, bufsize );
+
+  // Split the tasks in contiguous chunks, which are assigned to the threads in a fixed order.
+  // With BALANCE the chunks have a similar cost, otherwise the same number of tasks, so that
+  // the contributions are always summed in the same order
+  const bool share=( nt>1 || stride>1 );
+  const bool timetasks=( share && balance );
+  if( share ) {
+    partitionTasks( stride, rank, nt>1 ? 4*nt : 1 );
+    if( timetasks ) stepCost.assign( nactive_tasks, 0.0 );
+  } else {
+    taskChunks.resize(2); taskChunks[0]=0; taskChunks[1]=nactive_tasks;
+  }
+  const unsigned nchunks=taskChunks.size()-1;
+
+  // Make sure the thread local MultiValue objects have the right size
+  unsigned nquants=getNumberOfQuantities(), nder=getNumberOfDerivatives();
+  if( threadvals.size()<2*nt ) threadvals.resize( 2*nt );
+  for(unsigned i=0; i<2*nt; ++i) {
+    if( !threadvals[i] ) threadvals[i].reset( new MultiValue( nquants, nder ) );
+    else if( threadvals[i]->getNumberOfValues()!=nquants || threadvals[i]->getNumberOfDerivatives()!=nder ) threadvals[i]->resize( nquants, nder );
+  }
+
   if(timers) stopwatch.start("2 Loop over tasks");
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<double> omp_buffer;
-    if( nt>1 ) omp_buffer.resize( bufsize, 0.0 );
-    MultiValue myvals( getNumberOfQuantities(), getNumberOfDerivatives() );
-    MultiValue bvals( getNumberOfQuantities(), getNumberOfDerivatives() );
+    std::vector<double> & omp_buffer( nt>1 ? reduction.getBuffer( OpenMP::getThreadNum() ) : buffer );
+    MultiValue& myvals( *threadvals[2*OpenMP::getThreadNum()] );
+    MultiValue& bvals( *threadvals[2*OpenMP::getThreadNum()+1] );
     myvals.clearAll(); bvals.clearAll();
 
-    #pragma omp for nowait schedule(dynamic)
-    for(unsigned i=rank; i<nactive_tasks; i+=stride) {
-      // Calculate the stuff in the loop for this action
-      performTask( indexOfTaskInFullList[i], partialTaskList[i], myvals );
+    #pragma omp for nowait schedule(static,1)
+    for(unsigned c=0; c<nchunks; ++c) {
+      for(unsigned i=taskChunks[c]; i<taskChunks[c+1]; ++i) {
+        std::chrono::steady_clock::time_point start;
+        if( timetasks ) start=std::chrono::steady_clock::now();
+        // Calculate the stuff in the loop for this action
+        performTask( indexOfTaskInFullList[i], partialTaskList[i], myvals );
+
+        // Check for conditions that allow us to just to skip the calculation
+        // the condition is that the weight of the contribution is low
+        // N.B. Here weights are assumed to be between zero and one
+        if( myvals.get(0)>=tolerance ) {
+          // Now calculate all the functions
+          // If the contribution of this quantity is very small at neighbour list time ignore it
+          // untill next neighbour list time
+          calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
+        }
 
-      // Check for conditions that allow us to just to skip the calculation
-      // the condition is that the weight of the contribution is low
-      // N.B. Here weights are assumed to be between zero and one
-      if( myvals.get(0)<tolerance ) {
-        // Clear the derivatives
+        // Clear the value
         myvals.clearAll();
-        continue;
+        if( timetasks ) stepCost[i]=std::chrono::duration<double>( std::chrono::steady_clock::now()-start ).count();
       }
-
-      // Now calculate all the functions
-      // If the contribution of this quantity is very small at neighbour list time ignore it
-      // untill next neighbour list time
-      if( nt>1 ) {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
-      } else {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, buffer, der_list );
-      }
-
-      // Clear the value
-      myvals.clearAll();
     }
-    #pragma omp critical
-    if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
+    if( nt>1 ) reduction.reduce( buffer );
   }
   if(timers) stopwatch.stop("2 Loop over tasks");
   // Turn back on derivative calculation
@@ -331,6 +355,11 @@ void ActionWithVessel::runAllTasks() {
   if( mydata && !lowmem && !noderiv ) {
     comm.Sum( der_list ); mydata->setActiveValsAndDerivatives( der_list );
   }
+  // Store the costs of the tasks so they can be used to partition the tasks at the next step
+  if( timetasks ) {
+    if( stride>1 ) comm.Sum( stepCost );
+    for(unsigned i=0; i<nactive_tasks; ++i) taskCost[ indexOfTaskInFullList[i] ]=stepCost[i];
+  }
   // Update the elements that are makign contributions to the sum here
   // this causes problems if we do it in prepare
   if(timers) stopwatch.stop("3 MPI gather");
@@ -340,6 +369,40 @@ void ActionWithVessel::runAllTasks() {
   if(timers) stopwatch.stop("4 Finishing computations");
 }
 
+void ActionWithVessel::partitionTasks( const unsigned& stride, const unsigned& rank, const unsigned& nchunks ) {
+  std::vector<unsigned> bounds( stride*nchunks+1, nactive_tasks ); bounds[0]=0;
+  const unsigned nb=bounds.size()-1;
+  if( !balance ) {
+    // All the tasks are assumed to have the same cost, so every rank gets the same partition
+    for(unsigned k=1; k<nb; ++k) bounds[k]=( static_cast<unsigned long>(k)*nactive_tasks )/nb;
+    taskChunks.assign( bounds.begin()+rank*nchunks, bounds.begin()+(rank+1)*nchunks+1 );
+    return;
+  }
+  if( taskCost.size()!=fullTaskList.size() ) taskCost.assign( fullTaskList.size(), 0.0 );
+  // Tasks that have never been timed are assumed to cost as much as the average task
+  double known=0; unsigned nknown=0;
+  for(unsigned i=0; i<nactive_tasks; ++i) {
+    double cost=taskCost[ indexOfTaskInFullList[i] ];
+    if( cost>0 ) { known+=cost; nknown++; }
+  }
+  const double unknown=( nknown>0 ? known/nknown : 1.0 );
+
+  // The boundaries are computed on the first rank only so that all ranks use the same partition
+  if( rank==0 ) {
+    double total=0;
+    for(unsigned i=0; i<nactive_tasks; ++i) {
+      double cost=taskCost[ indexOfTaskInFullList[i] ]; total+=( cost>0 ? cost : unknown );
+    }
+    double cumulative=0; unsigned k=1;
+    for(unsigned i=0; i<nactive_tasks && k<nb; ++i) {
+      double cost=taskCost[ indexOfTaskInFullList[i] ]; cumulative+=( cost>0 ? cost : unknown );
+      while( k<nb && cumulative>=k*total/nb ) { bounds[k]=i+1; k++; }
+    }
+  }
+  if( stride>1 ) comm.Bcast( bounds, 0 );
+  taskChunks.assign( bounds.begin()+rank*nchunks, bounds.begin()+(rank+1)*nchunks+1 );
+}
+
 void ActionWithVessel::transformBridgedDerivatives( const unsigned& current, MultiValue& invals, MultiValue& outvals ) const {
   plumed_error();
 }
@@ -27,7 +27,9 @@
 #include "tools/Exception.h"
 #include "tools/DynamicList.h"
 #include "tools/MultiValue.h"
+#include "tools/ThreadReduction.h"
 #include <vector>
+#include <memory>
 #include "tools/ForwardDecl.h"
 
 namespace PLMD {
@@ -85,6 +87,20 @@ private:
   std::vector<unsigned> der_list;
 /// The buffer that we use (we keep a copy here to avoid resizing)
   std::vector<double> buffer;
+/// The per-thread copies of the buffer (we keep them here to avoid resizing)
+  ThreadReduction<double> reduction;
+/// The per-thread MultiValue objects (two per thread, we keep them here to avoid reallocation)
+  std::vector<std::unique_ptr<MultiValue> > threadvals;
+/// Do we split the tasks according to the time they took at the previous step
+  bool balance;
+/// The time taken by each task (indexed by position in the full list) the last time it was performed
+  std::vector<double> taskCost;
+/// The time taken by each active task in the current step
+  std::vector<double> stepCost;
+/// The boundaries of the chunks of active tasks that are done by this rank
+  std::vector<unsigned> taskChunks;
+/// Split the active tasks in contiguous chunks with about the same cost (or number of tasks without BALANCE)
+  void partitionTasks( const unsigned& stride, const unsigned& rank, const unsigned& nchunks );
 /// Do we want to output information on the timings of different parts of the calculation
   bool timers;
   ForwardDecl<Stopwatch> stopwatch_fwd;
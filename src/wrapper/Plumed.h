@@ -257,6 +257,35 @@
   When you compile the FORTRAN interface, wrapper functions are added with several possible
   name manglings, so you should not experience problems linking the plumed library with a FORTRAN file.
 
+\section ReferencePlumedH-handles Command handles
+
+  Every call to `cmd` requires PLUMED to split the string and to search the command in a table.
+  Codes that call `cmd` many times at every step can resolve the most frequent commands in advance
+  (available with API version 7):
+
+\verbatim
+  int handle;
+  plumed_cmd(p,"getCommandHandle setPositions",&handle);
+  char key[32];
+  sprintf(key,"#%d",handle);
+  ...
+  plumed_cmd(p,key,positions);  // same as plumed_cmd(p,"setPositions",positions)
+\endverbatim
+
+  From C++, the handle can be passed directly to \ref PLMD::Plumed::cmd(int,const void*), which takes care
+  of the corresponding key:
+
+\verbatim
+  int handle;
+  p.cmd("getCommandHandle setPositions",&handle);
+  ...
+  p.cmd(handle,positions);  // same as p.cmd("setPositions",positions)
+\endverbatim
+
+  Handles are only valid for the PLUMED kernel that returned them and cannot be obtained for commands
+  that take additional words (e.g. "getDataRank x" or "GREX setMPIIntracomm").
+  String commands keep working as usual.
+
 \section ReferencePlumedH-exceptions Error handling
 
   In case an error is detected by PLUMED, either because of some user error, some internal bug,
@@ -1727,6 +1756,43 @@ Plumed(Plumed&&p)__PLUMED_WRAPPER_CXX_NOEXCEPT :
     if(h.code!=0) rethrow(h);
   }
 
+private:
+  /**
+    Table of the keys "#<n>" used to pass the command handles that are most likely to be used.
+    It is built once, so that the keys are not formatted at every call.
+  */
+  class HandleKeys {
+  public:
+    enum { size=256 };
+  private:
+    char keys[size][8];
+  public:
+    HandleKeys() {
+      for(int i=0; i<size; i++) __PLUMED_WRAPPER_STD sprintf(keys[i],"#%d",i);
+    }
+    const char* operator[](int i) const {
+      return keys[i];
+    }
+  };
+
+public:
+  /**
+     Send a command to this plumed object using a command handle.
+     Available as of PLUMED 2.6 (it requires a kernel with API version 7).
+      \param handle The handle of the command, obtained with cmd("getCommandHandle ...")
+      \param val The argument
+      \note Same as \ref cmd(const char*,const void*) with key "#<handle>", see \ref ReferencePlumedH-handles.
+  */
+  void cmd(int handle,const void*val=NULL) {
+    static const HandleKeys table;
+    if(handle>=0 && handle<HandleKeys::size) cmd(table[handle],val);
+    else {
+      char key[32];
+      __PLUMED_WRAPPER_STD sprintf(key,"#%d",handle);
+      cmd(key,val);
+    }
+  }
+
   /**
      Destructor
 